@@ -2,6 +2,11 @@
 // Created by JellyfishKnight on 25-4-18.
 //
 #include "base_inference.hpp"
+#include <logger.hpp>
+#include <model_registry.hpp>
+#include <chrono>
+#include <cstring>
+#include <utility>
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
@@ -14,6 +19,7 @@ void BaseInference::set_dt(float dt)
 void BaseInference::set_use_filter(bool use)
 {
     use_filter = use;
+    warn_prediction_without_filter();
 }
 
 void BaseInference::set_q_factor(float factor)
@@ -31,9 +37,182 @@ bool BaseInference::use_filter_status() const
     return use_filter;
 }
 
+void BaseInference::set_output_filter(const OutputFilterSettings& settings)
+{
+    prediction_requested_ = settings.prediction.enabled;
+    pending_filter_settings_.store(std::make_shared<const OutputFilterSettings>(settings), std::memory_order_release);
+    warn_prediction_without_filter();
+}
+
+void BaseInference::warn_prediction_without_filter() const
+{
+    if (prediction_requested_ && !use_filter) {
+        LOG_WARN("已开启延迟补偿但未开启输出滤波，延迟补偿依赖滤波器估计的速度，关闭滤波时不生效");
+    }
+}
+
+void BaseInference::set_pipeline_latency(double seconds)
+{
+    pipeline_latency_ = seconds;
+}
+
+bool BaseInference::adopt_filter_settings()
+{
+    auto settings = pending_filter_settings_.exchange(nullptr, std::memory_order_acq_rel);
+    if (!settings) {
+        return false;
+    }
+    filter_settings_ = *settings;
+    return true;
+}
+
+void BaseInference::set_change_gate(const ChangeGateConfig& config)
+{
+    pending_change_gate_.store(std::make_shared<const ChangeGateConfig>(config), std::memory_order_release);
+}
+
+ChangeGateStats BaseInference::take_change_gate_stats()
+{
+    ChangeGateStats total;
+    for (auto& detector : change_detectors_) {
+        ChangeGateStats stats = detector.take_stats();
+        total.frames += stats.frames;
+        total.skipped += stats.skipped;
+    }
+    return total;
+}
+
+void BaseInference::set_uint8_input(bool enable)
+{
+    uint8_input_ = enable;
+}
+
+void BaseInference::set_execution_provider(const ExecutionProviderConfig& config)
+{
+    execution_provider_ = config;
+}
+
+void BaseInference::set_cascade(const CascadeConfig& config)
+{
+    cascade_config_ = config;
+    cascade_.configure(config);
+}
+
+CascadeStats BaseInference::take_cascade_stats()
+{
+    return cascade_.take_stats();
+}
+
+float BaseInference::frame_motion(int slot) const
+{
+    return slot < static_cast<int>(change_detectors_.size()) ? change_detectors_[slot].last_difference() : 0.0f;
+}
+
+bool BaseInference::select_cascade_model(float motion)
+{
+    ModelInstance* next = model_.get();
+    if (fast_model_) {
+        next = cascade_.want_full(motion) ? model_.get() : fast_model_.get();
+    }
+    if (next == active_) {
+        return false;
+    }
+    set_active(next);
+    return true;
+}
+
+void BaseInference::set_active(ModelInstance* instance)
+{
+    active_ = instance;
+    if (active_ != nullptr && active_->input_h > 0 && active_->input_w > 0 && active_->input_c > 0) {
+        input_h_ = active_->input_h;
+        input_w_ = active_->input_w;
+        input_c_ = active_->input_c;
+    }
+}
+
+void BaseInference::load_fast_model()
+{
+    fast_model_.reset();
+    if (!cascade_config_.enabled) {
+        return;
+    }
+    if (cascade_config_.fast_model.empty() || !file_exists(cascade_config_.fast_model)) {
+        LOG_WARN("未找到级联推理的小模型: {}，只使用完整模型", cascade_config_.fast_model);
+        return;
+    }
+    try {
+        auto instance = build_instance(cascade_config_.fast_model);
+        if (instance->batch_size != batch_size_) {
+            LOG_WARN("小模型批次大小为 {}，与完整模型的 {} 不一致，只使用完整模型", instance->batch_size, batch_size_);
+            return;
+        }
+        fast_model_ = std::move(instance);
+        cascade_.reset();
+        LOG_INFO("级联推理已开启，小模型: {}", cascade_config_.fast_model);
+    } catch (const std::exception& e) {
+        LOG_WARN("小模型加载失败，只使用完整模型: {}", e.what());
+    }
+}
+
+bool BaseInference::frame_changed(const cv::Mat& image, int slot)
+{
+    if (auto config = pending_change_gate_.exchange(nullptr, std::memory_order_acq_rel)) {
+        change_gate_config_ = *config;
+        for (auto& detector : change_detectors_) {
+            detector.configure(change_gate_config_);
+        }
+    }
+    if (slot >= static_cast<int>(change_detectors_.size())) {
+        size_t old_size = change_detectors_.size();
+        change_detectors_.resize(slot + 1);
+        for (size_t i = old_size; i < change_detectors_.size(); i++) {
+            change_detectors_[i].configure(change_gate_config_);
+        }
+    }
+    FrameChangeDetector& detector = change_detectors_[slot];
+    // 级联推理需要画面运动量，门控关闭时也要计算
+    detector.set_measure(fast_model_ != nullptr);
+    if (!has_output_) {
+        // 刚切换模型或尚未推理过，没有可沿用的输出
+        detector.reset();
+    }
+    return detector.changed(image);
+}
+
+bool BaseInference::is_ready() const
+{
+    // 有等待切换的模型时也视为就绪，推理时会先切换到新模型
+    return ready_.load() || has_pending_model_.load(std::memory_order_acquire);
+}
+
+void BaseInference::set_stage_timing(bool enable)
+{
+    stage_timing_ = enable;
+    stage_timings_ = {};
+}
+
+StageTimings BaseInference::take_stage_timings()
+{
+    return std::exchange(stage_timings_, StageTimings{});
+}
+
 void BaseInference::set_amp_map(const std::unordered_map<std::string, int>& amp_map)
 {
-    blendShapeAmpMap = amp_map;
+    {
+        std::lock_guard lock(transform_mutex_);
+        blendShapeAmpMap = amp_map;
+    }
+    publish_output_transform();
+}
+
+void BaseInference::set_offset_map(const std::unordered_map<std::string, float>& offset_map)
+{
+    {
+        std::lock_guard lock(transform_mutex_);
+        blendShapeOffsetMap = offset_map;
+    }
+    publish_output_transform();
 }
 
 const std::unordered_map<std::string, size_t>& BaseInference::getBlendShapeIndexMap()
@@ -93,114 +272,393 @@ void BaseInference::plot_curve(float raw, float filtered)
     cv::waitKey(1);
 }
 
-// 将原始数据放大增益
-void BaseInference::AmpMapToOutput(std::vector<float>& output)
+void BaseInference::publish_output_transform()
 {
-    for (int i = 0; i < blendShapes.size(); i++)
-    {
-        if (blendShapeAmpMap.contains(blendShapes[i]))
-        {
-            if (blendShapeAmpMap[blendShapes[i]] != 0)
-            {
-                output[i] = output[i] * (blendShapeAmpMap[blendShapes[i]] * 0.02 + 1);
-                output[i] = std::min(1.0f, output[i]);
-            }
-        }
-        // 对tongueRight进行额外的2.5倍放大处理
-        if (blendShapes[i] == "tongueRight") {
-            output[i] = output[i] * 2.5f;
-            // 确保值不超过1.0（如果需要限制在[0,1]范围内）
-            output[i] = std::min(1.0f, output[i]);
+    std::lock_guard lock(transform_mutex_);
+    auto transform = std::make_shared<const OutputTransform>(
+        OutputTransform::compile(blendShapes, blendShapeOffsetMap, blendShapeAmpMap));
+    pending_output_transform_.store(std::move(transform), std::memory_order_release);
+}
+
+void BaseInference::apply_output_transform(std::span<float> output)
+{
+    if (auto transform = pending_output_transform_.exchange(nullptr, std::memory_order_acq_rel)) {
+        output_transform_ = std::move(transform);
+    }
+    if (output_transform_) {
+        output_transform_->apply(output);
+    }
+}
+
+void BaseInference::write_input(const cv::Mat& input, int slot)
+{
+    const size_t slot_size = static_cast<size_t>(input_c_) * input_h_ * input_w_;
+    const size_t offset = static_cast<size_t>(slot) * slot_size;
+    // 灰度、缩放、归一化一次完成，直接写入输入缓冲区；uint8 输入只做灰度和缩放
+    if (input_c_ == 1) {
+        bool done = active_->uint8_input
+            ? fused_preprocessor_.run(input, active_->input_bytes.data() + offset, input_w_, input_h_)
+            : fused_preprocessor_.run(input, active_->input_data.data() + offset, input_w_, input_h_);
+        if (done) {
+            return;
         }
-        // // 应用偏置值
-        // if (blendShapeOffsetMap.contains(blendShapes[i]))
-        // {
-        //     // 应用偏置值，确保结果在0-1之间
-        //     output[i] = std::max(0.0f, std::min(1.0f, output[i] + blendShapeOffsetMap[blendShapes[i]]));
-        // }
     }
+    // 转换为灰度图（如果需要）
+    if (input.channels() == 3 && input_c_ == 1) {
+        cv::cvtColor(input, gray_image_, cv::COLOR_BGR2GRAY);
+    } else if (input.channels() == 1 && input_c_ == 3) {
+        cv::cvtColor(input, gray_image_, cv::COLOR_GRAY2BGR);
+    } else {
+        gray_image_ = input;
+    }
+    // 调整大小
+    cv::resize(gray_image_, processed_image_, cv::Size(input_w_, input_h_), cv::INTER_NEAREST);
+    // resize 的输出总是连续的，可以整块拷贝
+    if (active_->uint8_input) {
+        std::memcpy(active_->input_bytes.data() + offset, processed_image_.data,
+                    processed_image_.total() * processed_image_.elemSize());
+        return;
+    }
+    // 归一化处理
+    processed_image_.convertTo(processed_image_, CV_32F, 1.0 / 255.0);
+    std::memcpy(active_->input_data.data() + offset, processed_image_.data,
+                processed_image_.total() * processed_image_.elemSize());
 }
 
-void BaseInference::init_io_names() {
-    input_names_.clear();
-    output_names_.clear();
-    input_name_ptrs_.clear();
-    output_name_ptrs_.clear();
+void BaseInference::init_io_names(ModelInstance& instance) const {
+    instance.input_names.clear();
+    instance.output_names.clear();
+    instance.input_name_ptrs.clear();
+    instance.output_name_ptrs.clear();
+    instance.input_shapes.clear();
 
     Ort::AllocatorWithDefaultOptions allocator;
+    Ort::Session& session = *instance.session;
 
     // 获取输入信息
-    size_t num_input_nodes = session_->GetInputCount();
+    size_t num_input_nodes = session.GetInputCount();
 
     for (size_t i = 0; i < num_input_nodes; i++) {
-        auto name = session_->GetInputNameAllocated(i, allocator);
-        input_names_.push_back(name.get());
+        auto name = session.GetInputNameAllocated(i, allocator);
+        instance.input_names.push_back(name.get());
 
         // 获取输入形状
-        auto type_info = session_->GetInputTypeInfo(i);
+        auto type_info = session.GetInputTypeInfo(i);
         auto tensor_info = type_info.GetTensorTypeAndShapeInfo();
         auto shape = tensor_info.GetShape();
 
         // 动态维度处理
         for (size_t j = 0; j < shape.size(); j++) {
             if (shape[j] < 0) {
-                if (j == 0) shape[j] = 1;        // 批次大小
+                if (j == 0) shape[j] = requested_batch_size_; // 批次大小
                 else if (j == 1) shape[j] = 1;   // 通道数(灰度)
                 else if (j == 2) shape[j] = 256; // 高度
                 else if (j == 3) shape[j] = 256; // 宽度
             }
         }
 
-        input_shapes_.push_back(shape);
+        instance.input_shapes.push_back(shape);
     }
 
     // 更新指针数组 - 只需要执行一次
-    for (const auto& name : input_names_) {
-        input_name_ptrs_.push_back(name.c_str());
+    for (const auto& name : instance.input_names) {
+        instance.input_name_ptrs.push_back(name.c_str());
     }
 
     // 获取输出信息
-    size_t num_output_nodes = session_->GetOutputCount();
+    size_t num_output_nodes = session.GetOutputCount();
 
     for (size_t i = 0; i < num_output_nodes; i++) {
-        auto name = session_->GetOutputNameAllocated(i, allocator);
-        output_names_.push_back(name.get());
+        auto name = session.GetOutputNameAllocated(i, allocator);
+        instance.output_names.push_back(name.get());
     }
 
     // 更新指针数组 - 只需要执行一次
-    for (const auto& name : output_names_) {
-        output_name_ptrs_.push_back(name.c_str());
+    for (const auto& name : instance.output_names) {
+        instance.output_name_ptrs.push_back(name.c_str());
     }
 
-    // 设置输入维度信息
-    if (!input_shapes_.empty()) {
-        auto& shape = input_shapes_[0];
+    // 设置输入维度信息，形状中没有的维度保持构造时的设置
+    instance.batch_size = requested_batch_size_;
+    if (!instance.input_shapes.empty()) {
+        auto& shape = instance.input_shapes[0];
+        if (!shape.empty()) {
+            instance.batch_size = static_cast<int>(shape[0]);
+        }
         if (shape.size() >= 4) {
-            input_c_ = shape[1];
-            input_h_ = shape[2];
-            input_w_ = shape[3];
+            instance.input_c = static_cast<int>(shape[1]);
+            instance.input_h = static_cast<int>(shape[2]);
+            instance.input_w = static_cast<int>(shape[3]);
         }
     }
 }
 
-void BaseInference::allocate_buffers()
+void BaseInference::allocate_buffers(ModelInstance& instance) const
 {
-    // 预分配处理图像的内存
-    processed_image_ = cv::Mat(input_h_, input_w_, CV_32FC1);
-
-    // 预分配输入数据内存
-    if (!input_shapes_.empty()) {
+    // 预分配输入数据内存，uint8 输入的模型使用字节缓冲区
+    instance.uint8_input = false;
+    instance.input_data.clear();
+    instance.input_bytes.clear();
+    if (!instance.input_shapes.empty()) {
         size_t input_size = 1;
-        for (auto dim : input_shapes_[0]) {
+        for (auto dim : instance.input_shapes[0]) {
             input_size *= dim;
         }
-        input_data_.resize(input_size);
+        if (instance.session) {
+            auto element_type = instance.session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType();
+            instance.uint8_input = element_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+        }
+        if (instance.uint8_input) {
+            instance.input_bytes.resize(input_size);
+        } else {
+            instance.input_data.resize(input_size);
+        }
     }
 
     // 创建内存信息 - 只需创建一次
-    memory_info_ = Ort::MemoryInfo::CreateCpu(
+    instance.memory_info = Ort::MemoryInfo::CreateCpu(
         OrtAllocatorType::OrtArenaAllocator,
         OrtMemType::OrtMemTypeDefault
     );
+
+    instance.output_tensors.clear();
+    instance.output_data.clear();
+    if (!instance.session || !instance.io_binding || instance.input_name_ptrs.empty() || instance.output_name_ptrs.empty()) {
+        return;
+    }
+    Ort::IoBinding& io_binding = *instance.io_binding;
+    io_binding.ClearBoundInputs();
+    io_binding.ClearBoundOutputs();
+
+    // 输入张量直接包装预分配的输入缓冲区，之后每帧只需写入数据
+    if (instance.uint8_input) {
+        instance.input_tensor = Ort::Value::CreateTensor<uint8_t>(
+            instance.memory_info,
+            instance.input_bytes.data(),
+            instance.input_bytes.size(),
+            instance.input_shapes[0].data(),
+            instance.input_shapes[0].size()
+        );
+        LOG_INFO("模型输入为 uint8，归一化在模型内完成");
+    } else {
+        instance.input_tensor = Ort::Value::CreateTensor<float>(
+            instance.memory_info,
+            instance.input_data.data(),
+            instance.input_data.size(),
+            instance.input_shapes[0].data(),
+            instance.input_shapes[0].size()
+        );
+    }
+    io_binding.BindInput(instance.input_name_ptrs[0], instance.input_tensor);
+
+    // 输出形状固定（批次维度除外）时预分配输出缓冲区
+    instance.outputs_preallocated = true;
+    for (size_t i = 0; i < instance.output_name_ptrs.size(); i++) {
+        auto shape = instance.session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape();
+        size_t output_size = 1;
+        for (size_t j = 0; j < shape.size(); j++) {
+            if (shape[j] < 0) {
+                if (j != 0) {
+                    instance.outputs_preallocated = false;
+                    break;
+                }
+                shape[j] = instance.batch_size;
+            }
+            output_size *= shape[j];
+        }
+        if (!instance.outputs_preallocated) {
+            break;
+        }
+        instance.output_data.emplace_back(output_size);
+        instance.output_tensors.push_back(Ort::Value::CreateTensor<float>(
+            instance.memory_info,
+            instance.output_data.back().data(),
+            output_size,
+            shape.data(),
+            shape.size()
+        ));
+    }
+
+    if (instance.outputs_preallocated) {
+        for (size_t i = 0; i < instance.output_name_ptrs.size(); i++) {
+            io_binding.BindOutput(instance.output_name_ptrs[i], instance.output_tensors[i]);
+        }
+    } else {
+        LOG_WARN("模型输出形状不固定，输出缓冲区由 ONNX Runtime 分配");
+        instance.output_tensors.clear();
+        instance.output_data.clear();
+        for (size_t i = 0; i < instance.output_name_ptrs.size(); i++) {
+            io_binding.BindOutput(instance.output_name_ptrs[i], instance.memory_info);
+        }
+    }
+}
+
+void BaseInference::run_model()
+{
+    if (!active_ || !active_->io_binding || active_->input_name_ptrs.empty() || active_->output_name_ptrs.empty()) {
+        return;
+    }
+
+    try {
+        // 运行推理，结果直接写入绑定的输出缓冲区
+        active_->session->Run(Ort::RunOptions{nullptr}, *active_->io_binding);
+        if (!active_->outputs_preallocated) {
+            active_->output_tensors = active_->io_binding->GetOutputValues();
+        }
+        has_output_ = true;
+        if (fast_model_) {
+            // 记录输出供级联判断下一帧是否需要完整模型
+            size_t count = 0;
+            const float* output = first_output(count);
+            cascade_.observe(std::span<const float>(output, count), active_ == model_.get());
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("推理错误: {}", e.what());
+    }
+}
+
+void BaseInference::warm_up(ModelInstance& instance) const
+{
+    if ((instance.input_data.empty() && instance.input_bytes.empty()) || !instance.io_binding) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::fill(instance.input_data.begin(), instance.input_data.end(), 0.0f);
+    std::fill(instance.input_bytes.begin(), instance.input_bytes.end(), uint8_t{0});
+    // 预热结果不作为有效输出，异常交给调用者处理
+    instance.session->Run(Ort::RunOptions{nullptr}, *instance.io_binding);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("模型预热完成，耗时 {} ms", elapsed);
+}
+
+const float* BaseInference::first_output(size_t& count) const
+{
+    count = 0;
+    if (!has_output_ || !active_ || active_->output_tensors.empty()) {
+        return nullptr;
+    }
+    if (active_->outputs_preallocated) {
+        count = active_->output_data.front().size();
+        return active_->output_data.front().data();
+    }
+    const Ort::Value& output_tensor = active_->output_tensors.front();
+    count = output_tensor.GetTensorTypeAndShapeInfo().GetElementCount();
+    return output_tensor.GetTensorData<float>();
+}
+
+BaseInference::~BaseInference()
+{
+    wait_for_reload();
+}
+
+std::shared_ptr<ModelInstance> BaseInference::build_instance(const std::string& model_path)
+{
+    auto instance = std::make_shared<ModelInstance>();
+    instance->model_path = model_path;
+    instance->session = create_session(model_path);
+    instance->io_binding = std::make_shared<Ort::IoBinding>(*instance->session);
+
+    // 初始化输入和输出名称
+    init_io_names(*instance);
+
+    // 提前分配内存
+    allocate_buffers(*instance);
+
+    // 预热后再交给推理线程，首帧不再承担延迟初始化的开销
+    warm_up(*instance);
+    return instance;
+}
+
+void BaseInference::use_instance(std::shared_ptr<ModelInstance> instance)
+{
+    // 旧实例只被推理线程使用，替换后即可释放
+    model_ = std::move(instance);
+    batch_size_ = model_->batch_size;
+    set_active(model_.get());
+    has_output_ = false;
+    if (fast_model_ && fast_model_->batch_size != batch_size_) {
+        LOG_WARN("新模型批次大小与小模型不一致，关闭级联推理");
+        fast_model_.reset();
+    }
+    // 切换模型后先运行一次完整模型
+    cascade_.reset();
+    // 新模型的输入缓冲区是空的，各槽位都要重新推理
+    for (auto& detector : change_detectors_) {
+        detector.reset();
+    }
+    on_model_changed();
 }
 
+void BaseInference::load_model(const std::string& model_path)
+{
+    ready_ = false;
+    wait_for_reload();
+    // 同步加载优先，丢弃尚未切换的后台加载结果
+    has_pending_model_ = false;
+    pending_model_.store(nullptr);
+    try {
+        use_instance(build_instance(model_path));
+        load_fast_model();
+        ready_ = true;
+        LOG_INFO("模型加载完成: {}", model_path);
+        ModelRegistry::instance().log_memory_report();
+    } catch (const Ort::Exception& e) {
+        LOG_ERROR("ONNX Runtime 错误: {}", e.what());
+    } catch (const std::exception& e) {
+        LOG_ERROR("标准异常: {}", e.what());
+    }
+}
+
+void BaseInference::reload_model_async(const std::string& model_path)
+{
+    if (reloading_.exchange(true)) {
+        LOG_WARN("上一次模型加载尚未完成，忽略本次加载: {}", model_path);
+        return;
+    }
+    if (reload_thread_.joinable()) {
+        reload_thread_.join();
+    }
+    reload_thread_ = std::thread([this, model_path]() {
+        LOG_INFO("正在后台加载模型: {}", model_path);
+        auto& registry = ModelRegistry::instance();
+        // 释放之前切换下来、已无人使用的会话
+        registry.release_unused();
+        try {
+            auto instance = build_instance(model_path);
+            pending_model_.store(std::move(instance));
+            has_pending_model_.store(true, std::memory_order_release);
+            LOG_INFO("模型已在后台加载完成，将在下一帧切换: {}", model_path);
+        } catch (const Ort::Exception& e) {
+            LOG_ERROR("后台加载模型失败，继续使用当前模型: {}", e.what());
+        } catch (const std::exception& e) {
+            LOG_ERROR("后台加载模型失败，继续使用当前模型: {}", e.what());
+        }
+        reloading_ = false;
+    });
+}
+
+void BaseInference::adopt_pending_model()
+{
+    if (!has_pending_model_.load(std::memory_order_acquire)) {
+        return;
+    }
+    has_pending_model_.store(false, std::memory_order_relaxed);
+    auto instance = pending_model_.exchange(nullptr);
+    if (!instance) {
+        return;
+    }
+    if (model_ && instance->batch_size != batch_size_) {
+        LOG_WARN("新模型批次大小为 {}，与当前的 {} 不一致，放弃切换", instance->batch_size, batch_size_);
+        return;
+    }
+    use_instance(std::move(instance));
+    ready_ = true;
+    LOG_INFO("已切换到新模型: {}", model_->model_path);
+}
+
+void BaseInference::wait_for_reload()
+{
+    if (reload_thread_.joinable()) {
+        reload_thread_.join();
+    }
+}
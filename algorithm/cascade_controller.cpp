@@ -0,0 +1,57 @@
+//
+// Created by JellyfishKnight on 25-7-10.
+//
+#include "cascade_controller.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+void CascadeController::configure(const CascadeConfig& config)
+{
+    config_ = config;
+    config_.keyframe_interval = std::max(config_.keyframe_interval, 1);
+    reset();
+}
+
+void CascadeController::reset()
+{
+    last_output_.clear();
+    has_output_ = false;
+    escalate_ = true;
+    frames_since_full_ = 0;
+}
+
+bool CascadeController::want_full(float motion)
+{
+    bool full = escalate_
+        || frames_since_full_ + 1 >= config_.keyframe_interval
+        || motion > config_.motion_threshold;
+    if (full) {
+        stats_.full_frames++;
+        frames_since_full_ = 0;
+    } else {
+        stats_.fast_frames++;
+        frames_since_full_++;
+    }
+    return full;
+}
+
+void CascadeController::observe(std::span<const float> output, bool full)
+{
+    escalate_ = false;
+    if (has_output_ && last_output_.size() == output.size() && !full) {
+        // 小模型输出在一帧内大幅跳变时不可信，下一帧交给完整模型
+        float max_delta = 0;
+        for (size_t i = 0; i < output.size(); i++) {
+            max_delta = std::max(max_delta, std::abs(output[i] - last_output_[i]));
+        }
+        escalate_ = max_delta > config_.output_threshold;
+    }
+    last_output_.assign(output.begin(), output.end());
+    has_output_ = true;
+}
+
+CascadeStats CascadeController::take_stats()
+{
+    return std::exchange(stats_, CascadeStats{});
+}
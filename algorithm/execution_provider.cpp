@@ -0,0 +1,119 @@
+//
+// Created by JellyfishKnight on 25-7-11.
+//
+#include "execution_provider.hpp"
+#include <logger.hpp>
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+    // GetAvailableProviders 返回的名称
+    const char* ort_provider_name(ExecutionProvider provider)
+    {
+        switch (provider) {
+        case ExecutionProvider::Xnnpack: return "XnnpackExecutionProvider";
+        case ExecutionProvider::Dnnl: return "DnnlExecutionProvider";
+        case ExecutionProvider::OpenVino: return "OpenVINOExecutionProvider";
+        default: return "CPUExecutionProvider";
+        }
+    }
+
+    void append_dnnl(Ort::SessionOptions& options)
+    {
+        OrtDnnlProviderOptions* dnnl_options = nullptr;
+        Ort::ThrowOnError(Ort::GetApi().CreateDnnlProviderOptions(&dnnl_options));
+        OrtStatus* status = Ort::GetApi().SessionOptionsAppendExecutionProvider_Dnnl(
+            static_cast<OrtSessionOptions*>(options), dnnl_options);
+        Ort::GetApi().ReleaseDnnlProviderOptions(dnnl_options);
+        Ort::ThrowOnError(status);
+    }
+}
+
+const char* execution_provider_name(ExecutionProvider provider)
+{
+    switch (provider) {
+    case ExecutionProvider::Auto: return "auto";
+    case ExecutionProvider::Cpu: return "cpu";
+    case ExecutionProvider::Xnnpack: return "xnnpack";
+    case ExecutionProvider::Dnnl: return "dnnl";
+    case ExecutionProvider::OpenVino: return "openvino";
+    }
+    return "cpu";
+}
+
+bool parse_execution_provider(const std::string& name, ExecutionProvider& provider)
+{
+    for (auto candidate : {ExecutionProvider::Auto, ExecutionProvider::Cpu, ExecutionProvider::Xnnpack,
+                           ExecutionProvider::Dnnl, ExecutionProvider::OpenVino}) {
+        if (name == execution_provider_name(candidate)) {
+            provider = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool execution_provider_available(ExecutionProvider provider)
+{
+    if (provider == ExecutionProvider::Auto || provider == ExecutionProvider::Cpu) {
+        return true;
+    }
+    auto providers = Ort::GetAvailableProviders();
+    return std::find(providers.begin(), providers.end(), ort_provider_name(provider)) != providers.end();
+}
+
+std::vector<ExecutionProvider> available_cpu_execution_providers()
+{
+    std::vector<ExecutionProvider> result{ExecutionProvider::Cpu};
+    for (auto provider : {ExecutionProvider::Xnnpack, ExecutionProvider::Dnnl, ExecutionProvider::OpenVino}) {
+        if (execution_provider_available(provider)) {
+            result.push_back(provider);
+        }
+    }
+    return result;
+}
+
+ExecutionProvider append_execution_provider(Ort::SessionOptions& options, const ExecutionProviderConfig& config)
+{
+    const ExecutionProvider provider = config.provider;
+    if (provider == ExecutionProvider::Auto || provider == ExecutionProvider::Cpu) {
+        return ExecutionProvider::Cpu;
+    }
+    const char* name = execution_provider_name(provider);
+    if (!execution_provider_available(provider)) {
+        LOG_WARN("当前 ONNX Runtime 未编译 {} 执行提供者，使用默认 CPU 执行提供者", name);
+        return ExecutionProvider::Cpu;
+    }
+    const std::string threads = std::to_string(config.threads);
+    try {
+        switch (provider) {
+        case ExecutionProvider::Xnnpack: {
+            std::unordered_map<std::string, std::string> provider_options;
+            if (config.threads > 0) {
+                provider_options["intra_op_num_threads"] = threads;
+            }
+            options.AppendExecutionProvider("XNNPACK", provider_options);
+            break;
+        }
+        case ExecutionProvider::Dnnl:
+            append_dnnl(options);
+            break;
+        case ExecutionProvider::OpenVino: {
+            std::unordered_map<std::string, std::string> provider_options{{"device_type", "CPU"}};
+            if (config.threads > 0) {
+                provider_options["num_of_threads"] = threads;
+            }
+            options.AppendExecutionProvider_OpenVINO_V2(provider_options);
+            break;
+        }
+        default:
+            return ExecutionProvider::Cpu;
+        }
+    } catch (const Ort::Exception& e) {
+        LOG_WARN("无法启用 {} 执行提供者: {}，使用默认 CPU 执行提供者", name, e.what());
+        return ExecutionProvider::Cpu;
+    }
+    LOG_INFO("已启用 {} 执行提供者", name);
+    return provider;
+}
@@ -2,66 +2,138 @@
 // Created by JellyfishKnight on 25-4-18.
 //
 #include "eye_inference.hpp"
+#include "model_registry.hpp"
 
+#include <algorithm>
 #include <logger.hpp>
 #include <opencv2/imgproc.hpp>
 
-#include <QFile>  // 用于读取资源文件
-#include <QString>  // 用于字符串转换
-EyeInference::EyeInference()
+EyeInference::EyeInference(int batch_size)
 {
     input_h_ = 112;
     input_w_ = 112;
     input_c_ = 1;
+    requested_batch_size_ = std::max(1, batch_size);
+    batch_size_ = requested_batch_size_;
     // 设置卡尔曼滤波参数
     dt = 0.02f;        // 假设50fps，则dt=0.02
     q_factor = 5.0f;   // 过程噪声系数
     r_factor = 0.0003f;  // 测量噪声系数
-    EyeInference::init_kalman_filter();
+    EyeInference::init_output_filter();
     // 初始化BlendShape索引映射
     EyeInference::initBlendShapeIndexMap();
     // 默认开启滤波
     use_filter = true;
     last_use_filter = use_filter;
+    slot_last_use_filter_.assign(batch_size_, use_filter);
+    slot_valid_.assign(batch_size_, false);
+    slot_changed_.assign(batch_size_, false);
+    slot_results_.assign(batch_size_, std::vector<float>(EYE_OUTPUT_SIZE));
 }
 
 
+EyeInference::~EyeInference()
+{
+    // 后台加载会调用 create_session，必须在派生类析构前结束
+    wait_for_reload();
+}
+
 void EyeInference::inference(cv::Mat image) {
+    // 后台加载的新模型在这里切换
+    adopt_pending_model();
+    if (!model_) {
+        return;
+    }
     if (!image.empty()) {
+        slot_valid_[0] = true;
+        // 画面没有变化时沿用上一次的模型输出，get_output 仍会推进滤波
+        if (!frame_changed(image)) {
+            return;
+        }
+        // 开启级联时按画面运动选择小模型或完整模型
+        select_cascade_model(frame_motion());
         // 预处理图像 - 直接修改预分配的内存
-        preprocess(image);
+        {
+            StageTimer timer(stage_timing_, stage_timings_.preprocess_ms);
+            preprocess(image);
+        }
         // 运行模型
-        run_model();
+        {
+            StageTimer timer(stage_timing_, stage_timings_.run_model_ms);
+            run_model();
+        }
         // 处理结果
         process_results();
     }
 }
-std::vector<float> EyeInference::get_output() {
-    if (output_tensors_.empty()) {
-        return {};
+
+void EyeInference::inference_batch(const std::vector<cv::Mat>& images) {
+    // 后台加载的新模型在这里切换
+    adopt_pending_model();
+    if (!model_) {
+        return;
+    }
+    bool has_input = false;
+    float motion = 0;
+    for (int slot = 0; slot < batch_size_; slot++) {
+        slot_valid_[slot] = slot < static_cast<int>(images.size()) && !images[slot].empty();
+        // 没有新图像的槽位保留上一帧的输入，其输出在本帧被忽略
+        // 画面没有变化的槽位同样保留上一次的输入，其输出仍然有效
+        slot_changed_[slot] = slot_valid_[slot] && frame_changed(images[slot], slot);
+        if (slot_changed_[slot]) {
+            motion = std::max(motion, frame_motion(slot));
+            has_input = true;
+        }
     }
+    // 所有槽位都没有变化时不运行模型
+    if (has_input) {
+        // 所有槽位共用一个模型，切换模型后各有效槽位都要写入新模型的输入缓冲区
+        bool switched = select_cascade_model(motion);
+        for (int slot = 0; slot < batch_size_; slot++) {
+            if (slot_changed_[slot] || (switched && slot_valid_[slot])) {
+                StageTimer timer(stage_timing_, stage_timings_.preprocess_ms);
+                preprocess(images[slot], slot);
+            }
+        }
+        // 所有槽位共用一次 Run
+        {
+            StageTimer timer(stage_timing_, stage_timings_.run_model_ms);
+            run_model();
+        }
+        process_results();
+    }
+}
 
-    try {
-        // 获取第一个输出张量
-        const Ort::Value& output_tensor = output_tensors_.front();
-        const auto* output_data = output_tensor.GetTensorData<float>();
+std::span<const float> EyeInference::get_output() {
+    return get_output(0);
+}
 
-        // 获取输出形状
-        auto shape_info = output_tensor.GetTensorTypeAndShapeInfo();
-        auto output_shape = shape_info.GetShape();
+std::span<const float> EyeInference::get_output(int slot) {
+    if (slot < 0 || slot >= batch_size_) {
+        return {};
+    }
+    if (batch_size_ > 1 && !slot_valid_[slot]) {
+        return {};
+    }
+    size_t output_size = 0;
+    const float* output_data = first_output(output_size);
+    if (output_data == nullptr) {
+        return {};
+    }
 
-        // 计算输出大小
-        size_t output_size = 1;
-        for (auto dim : output_shape) {
-            output_size *= dim;
-        }
+    try {
+        // 输出第 0 维为批次，按槽位切分
+        size_t slot_size = output_size / batch_size_;
+        const float* slot_data = output_data + slot * slot_size;
 
-        // 复制数据到结果向量
-        std::vector<float> result(output_data, output_data + output_size);
-        result.resize(EYE_OUTPUT_SIZE); // 确保输出大小正确
+        // 复制数据到该槽位预分配的结果缓冲区
+        std::vector<float>& result = slot_results_[slot];
+        std::fill(result.begin(), result.end(), 0.0f);
+        std::copy_n(slot_data, std::min(slot_size, result.size()), result.begin());
 
         if (use_filter)
         {
+            StageTimer timer(stage_timing_, stage_timings_.filter_ms);
 #ifdef DEBUG
             float raw = 0;
             float eye_openness = 0;
@@ -76,42 +148,24 @@ std::vector<float> EyeInference::get_output() {
                 }
             }
 #endif
-            if (last_use_filter != use_filter)
+            if (adopt_filter_settings())
             {
-                last_use_filter = use_filter;
-                // 使用CV_64F类型创建矩阵
-                cv::Mat input(result.size(), 1, CV_64F);
-                for (size_t i = 0; i < result.size(); ++i) {
-                    input.at<double>(i, 0) = static_cast<double>(result[i]);
-                }
-                kalman_filter_.set_state(input.clone());
+                // 所有槽位一起切换
+                init_output_filter();
             }
-
-            // 预测
-            auto temp = kalman_filter_.predict();
-
-            if (!result.empty())
+            if (slot_last_use_filter_[slot] != use_filter)
             {
-                // 创建一个CV_64F类型的测量矩阵
-                cv::Mat measure(result.size(), 1, CV_64F);
-                for (size_t i = 0; i < result.size(); ++i) {
-                    measure.at<double>(i, 0) = static_cast<double>(result[i]);
-                }
-
-                // 更新滤波器
-                kalman_filter_.correct(measure);
-
-                // 将状态后验矩阵中的数据复制回result
-                for (int i = 0; i < result.size(); ++i) {
-                    result[i] = static_cast<float>(kalman_filter_.state_post_.at<double>(i, 0));
-                }
+                slot_last_use_filter_[slot] = use_filter;
+                slot_filters_[slot].reset();
+                slot_predictors_[slot].reset();
             }
-            else
+            slot_filters_[slot].apply(result, filter_step());
+            LatencyPredictor& predictor = slot_predictors_[slot];
+            if (predictor.enabled())
             {
-                // 将预测结果复制回result
-                for (int i = 0; i < result.size(); ++i) {
-                    result[i] = static_cast<float>(temp.at<double>(i, 0));
-                }
+                // 按测得的延迟沿滤波器速度外推
+                slot_filters_[slot].velocities(velocity_buffer_);
+                predictor.apply(result, velocity_buffer_, dt, predictor.horizon(pipeline_latency_));
             }
 
 #ifdef DEBUG
@@ -131,227 +185,94 @@ std::vector<float> EyeInference::get_output() {
 #endif
         }
 
-        // 输出限幅以及增益调整
-        // AmpMapToOutput(result);
-
         return result;
     }
     catch (const std::exception& e)
     {
         LOG_ERROR("获取输出数据错误: {}", e.what());
-        return std::vector<float>();
+        return {};
     }
 }
-void EyeInference::load_model(const std::string &model_path) {
+std::shared_ptr<Ort::Session> EyeInference::create_session(const std::string &model_path) {
+    // 优先映射外部模型文件，内嵌资源只作为回退
+    const std::string embedded_model_path = ":/models/model/eye_model.onnx";
+    std::string actual_model_path = model_path.empty() ? embedded_model_path : model_path;
+
+    // 配置会话选项，线程数等执行参数由注册表按本机测试结果设置
+    Ort::SessionOptions session_options;
+    session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    session_options.EnableCpuMemArena();
+
+    ExecutionProvider provider = append_execution_provider(session_options, execution_provider_);
+
+    SessionRequest request;
+    request.model_path = actual_model_path;
+    request.fallback_path = embedded_model_path;
+    request.options_tag = std::string("eye_") + execution_provider_name(provider);
+    // 其它执行提供者会把子图编译为无法保存的节点，只缓存默认 CPU 执行提供者的会话
+    request.use_cache = provider == ExecutionProvider::Cpu;
+    request.default_tuning.intra_op_threads = 2;
+    request.uint8_input = uint8_input_;
+    // 批量推理时会话参数按左右眼合并后的批次测试
+    request.batch_size = requested_batch_size_;
+
+    // 从注册表获取共享会话，左右眼共用同一个会话
+    auto& registry = ModelRegistry::instance();
+    if (provider == ExecutionProvider::Cpu) {
+        return registry.acquire_session(request, session_options);
+    }
     try {
-        std::string actual_model_path = ":/models/model/eye_model.onnx";
-
-        if (actual_model_path.substr(0, 2) == ":/") {
-            // 从Qt资源加载
-            //LOG_INFO("从Qt资源加载模型...");
-
-            QFile resourceFile(QString::fromStdString(actual_model_path));
-            if (!resourceFile.open(QIODevice::ReadOnly)) {
-                LOG_ERROR("无法打开资源文件: {}", actual_model_path);
-                LOG_ERROR("资源文件是否存在: {}", QFile::exists(QString::fromStdString(actual_model_path)) ? "是" : "否");
-                return;
-            }
-
-            QByteArray modelData = resourceFile.readAll();
-            resourceFile.close();
-
-            // 创建环境 - 只需要创建一次
-            static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "ONNXRuntimeDemo");
-
-            // 配置会话选项
-            session_options.SetIntraOpNumThreads(2);
-            session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-            session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-            session_options.AddConfigEntry("session.intra_op.allow_spinning", "0");
-            session_options.EnableCpuMemArena();
-            session_options.DisableMemPattern();
-
-            // 使用内存数据创建会话
-            session_ = std::make_shared<Ort::Session>(
-                env,
-                reinterpret_cast<const void*>(modelData.constData()),
-                static_cast<size_t>(modelData.size()),
-                session_options);
-        } else {
-            // 从文件系统加载（保留原有代码的兼容性）
-            // LOG_INFO("从文件系统加载眼睛模型: {}", actual_model_path);
-            //
-            // if (!file_exists(actual_model_path)) {
-            //     LOG_ERROR("错误：模型文件不存在: {}", actual_model_path);
-            //     return;
-            // }
-
-            // 创建环境 - 只需要创建一次
-            static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "ONNXRuntimeDemo");
-
-            // 配置会话选项
-            session_options.SetIntraOpNumThreads(2);
-            session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-            session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-            session_options.AddConfigEntry("session.intra_op.allow_spinning", "0");
-            session_options.EnableCpuMemArena();
-            session_options.DisableMemPattern();
-
-            // 转换为宽字符路径
-            std::wstring wmodel_path = utf8_to_wstring(actual_model_path);
-
-            // 创建会话
-            session_ = std::make_shared<Ort::Session>(env, wmodel_path.c_str(), session_options);
-        }
-
-        io_binding_ = std::make_shared<Ort::IoBinding>(*session_);
-
-        // 初始化输入和输出名称
-        init_io_names();
-
-        // 提前分配内存
-        allocate_buffers();
-
-        LOG_INFO("眼睛模型加载完成");
+        return registry.acquire_session(request, session_options);
     } catch (const Ort::Exception& e) {
-        LOG_ERROR("ONNX Runtime 错误: {}", e.what());
-    } catch (const std::exception& e) {
-        LOG_ERROR("标准异常: {}", e.what());
+        LOG_WARN("使用 {} 执行提供者创建会话失败: {}，使用默认 CPU 执行提供者", execution_provider_name(provider), e.what());
+        Ort::SessionOptions cpu_options;
+        cpu_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        cpu_options.EnableCpuMemArena();
+        request.options_tag = "eye_cpu";
+        request.use_cache = true;
+        return registry.acquire_session(request, cpu_options);
     }
 }
 
-void EyeInference::init_kalman_filter() {
-    int pos_size = EYE_OUTPUT_SIZE; // 使用眼睛输出大小
-    int state_size = pos_size * 2;  // 状态向量扩展为 [位置, 速度]
-
-    // 初始化协方差矩阵 P，状态维度为 state_size
-    cv::Mat P = cv::Mat::eye(state_size, state_size, CV_64F) * 1.0;
-
-    // 过程噪声 Q：这里采用常数速度模型的过程噪声，使用 dt 的多项式因子
-    auto update_Q = [state_size, pos_size, this]() {
-        cv::Mat Q = cv::Mat::zeros(state_size, state_size, CV_64F);
-        double dt2 = dt * dt;
-        double dt3 = dt2 * dt;
-        double dt4 = dt3 * dt;
-        cv::Mat I_pos = cv::Mat::eye(pos_size, pos_size, CV_64F);
-
-        // 位置部分：dt^4/4 * q_factor^2
-        Q(cv::Rect(0, 0, pos_size, pos_size)) = I_pos * (dt4 / 4.0 * q_factor * q_factor);
-
-        // 位置-速度 交叉项：dt^3/2 * q_factor^2
-        Q(cv::Rect(pos_size, 0, pos_size, pos_size)) = I_pos * (dt3 / 2.0 * q_factor * q_factor);
-        Q(cv::Rect(0, pos_size, pos_size, pos_size)) = I_pos * (dt3 / 2.0 * q_factor * q_factor);
-
-        // 速度部分：dt^2 * q_factor^2
-        Q(cv::Rect(pos_size, pos_size, pos_size, pos_size)) = I_pos * (dt2 * q_factor * q_factor);
-
-        return Q;
-    };
-
-    // 测量噪声 R：假设测量仅包含位置部分，尺寸为 pos_size x pos_size
-    auto update_R = [pos_size, this](const cv::Mat& measurement) {
-        return cv::Mat::eye(pos_size, pos_size, CV_64F) * r_factor;
-    };
-
-    // 定义状态转移矩阵 F = [ I, dt*I; 0, I ]
-    auto TransMat = [state_size, pos_size, this](const cv::Mat& state) {
-        cv::Mat F = cv::Mat::eye(state_size, state_size, CV_64F);
-        cv::Mat I_pos = cv::Mat::eye(pos_size, pos_size, CV_64F);
-        // 将上半部分右侧的子矩阵设为 dt * I，即位置更新依赖于速度
-        F(cv::Rect(pos_size, 0, pos_size, pos_size)) = I_pos * dt;
-
-        return F;
-    };
-
-    // 定义测量矩阵函数 H = [ I, 0 ]，只观测位置部分
-    auto MeasureMat = [pos_size, state_size](const cv::Mat& state) {
-        cv::Mat H = cv::Mat::zeros(pos_size, state_size, CV_64F);
-        cv::Mat I_pos = cv::Mat::eye(pos_size, pos_size, CV_64F);
-        I_pos.copyTo(H(cv::Rect(0, 0, pos_size, pos_size)));
-        return H;
-    };
-
-    kalman_filter_ = KalmanFilter(TransMat, MeasureMat, update_Q, update_R, P.clone());
-}
-
-void EyeInference::preprocess(const cv::Mat& input) {
-    // 转换为灰度图（如果需要）
-    if (input.channels() == 3 && input_c_ == 1) {
-        cv::cvtColor(input, gray_image_, cv::COLOR_BGR2GRAY);
-    } else if (input.channels() == 1 && input_c_ == 3) {
-        cv::cvtColor(input, gray_image_, cv::COLOR_GRAY2BGR);
-    } else {
-        gray_image_ = input;
+void EyeInference::on_model_changed() {
+    // 模型批次维度固定时无法批量推理，退回单眼模式
+    if (static_cast<int>(slot_results_.size()) != batch_size_) {
+        LOG_WARN("眼睛模型批次维度固定为 {}，无法使用批量推理", batch_size_);
+        slot_last_use_filter_.assign(batch_size_, use_filter);
+        slot_valid_.assign(batch_size_, false);
+        slot_changed_.assign(batch_size_, false);
+        slot_results_.assign(batch_size_, std::vector<float>(EYE_OUTPUT_SIZE));
+        init_output_filter();
     }
-    // 调整大小
-    cv::resize(gray_image_, processed_image_, cv::Size(input_w_, input_h_), cv::INTER_NEAREST);
-    // 归一化处理 - 避免不必要的数据复制
-    processed_image_.convertTo(processed_image_, CV_32F, 1.0 / 255.0);
-    // 直接拷贝到输入数据缓冲区
-    if (processed_image_.isContinuous()) {
-        std::memcpy(input_data_.data(), processed_image_.ptr<float>(),
-                   processed_image_.total() * sizeof(float));
-    } else {
-        // 如果数据不连续，则逐行拷贝
-        size_t row_bytes = processed_image_.cols * processed_image_.elemSize();
-        for (int i = 0; i < processed_image_.rows; ++i) {
-            std::memcpy(input_data_.data() + i * processed_image_.cols,
-                       processed_image_.ptr(i), row_bytes);
-        }
-    }
-
 }
 
-void EyeInference::run_model() {
-    if (!session_ || input_name_ptrs_.empty() || output_name_ptrs_.empty()) {
-        return;
+void EyeInference::init_output_filter() {
+    // 前 6 个点为眼睑轮廓，最后 1 个点为瞳孔中心
+    std::vector<std::string> groups(EYE_OUTPUT_SIZE, "eyelid");
+    groups[EYE_OUTPUT_SIZE - 2] = "pupil";
+    groups[EYE_OUTPUT_SIZE - 1] = "pupil";
+    // 每个批次槽位各自维护一份滤波状态
+    slot_filters_.clear();
+    slot_filters_.resize(batch_size_);
+    slot_predictors_.assign(batch_size_, LatencyPredictor{});
+    for (int slot = 0; slot < batch_size_; slot++) {
+        slot_filters_[slot].configure(groups, filter_settings_);
+        slot_predictors_[slot].configure(filter_settings_.prediction, groups.size());
     }
+    velocity_buffer_.assign(groups.size(), 0.0f);
+}
 
-    try {
-        // 创建输入张量 - 使用预分配的内存
-        input_tensor_ = Ort::Value::CreateTensor<float>(
-            memory_info_,
-            input_data_.data(),
-            input_data_.size(),
-            input_shapes_[0].data(),
-            input_shapes_[0].size()
-        );
+void EyeInference::preprocess(const cv::Mat& input) {
+    preprocess(input, 0);
+}
 
-        // 绑定输入
-        io_binding_->BindInput(input_name_ptrs_[0], input_tensor_);
-        // 绑定输出
-        for (size_t i = 0; i < output_name_ptrs_.size(); i++) {
-            io_binding_->BindOutput(output_name_ptrs_[i], memory_info_);
-        }
-        // 运行推理
-        session_->Run(Ort::RunOptions{nullptr}, *io_binding_);
-        // 获取输出
-        output_tensors_ = io_binding_->GetOutputValues();
-    } catch (const std::exception& e) {
-        LOG_ERROR("推理错误: {}", e.what());
-    }
+void EyeInference::preprocess(const cv::Mat& input, int slot) {
+    // 写入当前槽位在输入缓冲区中的位置
+    write_input(input, slot);
 }
 
 void EyeInference::process_results() {
-    if (output_tensors_.empty()) {
-        return;
-    }
-
-    // 处理第一个输出
-    try {
-        Ort::Value& output_tensor = output_tensors_.front();
-        // 获取输出形状
-        auto shape_info = output_tensor.GetTensorTypeAndShapeInfo();
-        auto output_shape = shape_info.GetShape();
-
-        // 计算输出大小
-        auto output_size = 1;
-        for (auto dim : output_shape) {
-            output_size *= dim;
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR("处理结果出错: {}", e.what());
-    }
+    // 输出已直接写入绑定的缓冲区，无需额外处理
 }
 
 void EyeInference::initBlendShapeIndexMap() {
@@ -18,14 +18,14 @@
  * Licensed under the Apache License, Version 2.0
  */
 #include "face_inference.hpp"
+#include "model_registry.hpp"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <onnxruntime_cxx_api.h>
 #include <onnxruntime_c_api.h>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
-#include <QFile>  // 用于读取资源文件
-#include <QString>  // 用于字符串转换
 #include <QFile>
 #include <QStandardPaths>
 #ifdef USE_CUDA
@@ -33,430 +33,235 @@
 #endif
 FaceInference::FaceInference()
 {
-    init_kalman_filter();
     initBlendShapeIndexMap();
+    init_output_filter();
     input_h_ = 224;
     input_w_ = 224;
     input_c_ = 1;
+    result_.resize(kBlendShapeCount);
 }
-void FaceInference::load_model(const std::string &model_path) {
-    try {
-        std::string actual_model_path = ":/models/model/face_model.onnx";
-
-        // 创建环境 - 只需要创建一次
-        static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "ONNXRuntimeDemo");
-
-        // 配置会话选项
-        session_options.SetIntraOpNumThreads(1);  // 对于GPU推理，减少CPU线程数
-        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-        session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-        session_options.AddConfigEntry("session.intra_op.allow_spinning", "0");
-        session_options.EnableCpuMemArena();
-        session_options.DisableMemPattern();
-        
-        // 添加针对CUDA的优化配置
-        session_options.AddConfigEntry("session.disable_prepacking", "0");
-        session_options.AddConfigEntry("session.enable_memory_pattern", "0");
-
-        // 检查CUDA可用性并启用
-        auto providers = Ort::GetAvailableProviders();
-        LOG_INFO("Available ONNX Runtime providers:");
-        for (const auto& p : providers) {
-            LOG_INFO("  - {}", p);
-        }
-        
-        bool cuda_is_available = false;
-        for (const auto& p : providers) {
-            if (p == "CUDAExecutionProvider") {
-                cuda_is_available = true;
-                break;
-            }
+std::shared_ptr<Ort::Session> FaceInference::create_session(const std::string &model_path) {
+    // 优先映射外部模型文件，内嵌资源只作为回退
+    const std::string embedded_model_path = ":/models/model/face_model.onnx";
+    std::string actual_model_path = model_path.empty() ? embedded_model_path : model_path;
+
+    // 配置会话选项，线程数等执行参数由注册表按本机测试结果设置
+    Ort::SessionOptions session_options;
+    session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    session_options.EnableCpuMemArena();
+    
+    // 添加针对CUDA的优化配置
+    session_options.AddConfigEntry("session.disable_prepacking", "0");
+    session_options.AddConfigEntry("session.enable_memory_pattern", "0");
+
+    // 检查CUDA可用性并启用
+    auto providers = Ort::GetAvailableProviders();
+    LOG_INFO("Available ONNX Runtime providers:");
+    for (const auto& p : providers) {
+        LOG_INFO("  - {}", p);
+    }
+    
+    // 指定了 CPU 执行提供者时不使用 CUDA
+    const bool allow_cuda = execution_provider_.provider == ExecutionProvider::Auto;
+    bool cuda_is_available = false;
+    for (const auto& p : providers) {
+        if (p == "CUDAExecutionProvider" && allow_cuda) {
+            cuda_is_available = true;
+            break;
         }
+    }
 
-        if (cuda_is_available) {
-            LOG_INFO("CUDA is available, attempting to enable CUDA execution provider for face inference.");
-            
-            try {
-                // 使用官方推荐的CUDA初始化方式
-                OrtCUDAProviderOptionsV2* cuda_options = nullptr;
-                Ort::ThrowOnError(Ort::GetApi().CreateCUDAProviderOptions(&cuda_options));
-                
-                std::vector<const char*> keys{"device_id", "gpu_mem_limit", "arena_extend_strategy", 
-                                             "cudnn_conv_algo_search", "do_copy_in_default_stream", 
-                                             "cudnn_conv_use_max_workspace", "cudnn_conv1d_pad_to_nc1d",
-                                             "enable_cuda_graph"};
-                std::vector<const char*> values{"0", "4294967296", "kNextPowerOfTwo", 
-                                               "EXHAUSTIVE", "1", "1", "1", "0"};
-                
-                Ort::ThrowOnError(Ort::GetApi().UpdateCUDAProviderOptions(cuda_options, keys.data(), values.data(), keys.size()));
-                
-                // 添加CUDA执行提供者
-                Ort::ThrowOnError(Ort::GetApi().SessionOptionsAppendExecutionProvider_CUDA_V2(
-                    static_cast<OrtSessionOptions*>(session_options), cuda_options));
-                
-                // 释放提供者选项
-                Ort::GetApi().ReleaseCUDAProviderOptions(cuda_options);
-                LOG_INFO("CUDA execution provider successfully configured for face inference.");
-            } catch (const Ort::Exception& e) {
-                LOG_WARN("Failed to configure CUDA execution provider: {}. Falling back to CPU.", e.what());
-                cuda_is_available = false;
-            } catch (const std::exception& e) {
-                LOG_WARN("Failed to configure CUDA execution provider: {}. Falling back to CPU.", e.what());
-                cuda_is_available = false;
-            }
-        }
+    if (cuda_is_available) {
+        LOG_INFO("CUDA is available, attempting to enable CUDA execution provider for face inference.");
         
-        if (!cuda_is_available) {
-            LOG_INFO("Using CPU execution provider for face inference.");
-            // CPU执行提供者会自动添加，无需显式配置
-        }
-
-        if (actual_model_path.substr(0, 2) == ":/") {
-            // 从Qt资源加载
-            //LOG_INFO("从Qt资源加载模型...");
-
-            QFile resourceFile(QString::fromStdString(actual_model_path));
-            if (!resourceFile.open(QIODevice::ReadOnly)) {
-                LOG_ERROR("无法打开资源文件: {}", actual_model_path);
-                LOG_ERROR("资源文件是否存在: {}", QFile::exists(QString::fromStdString(actual_model_path)) ? "是" : "否");
-                return;
-            }
-
-            QByteArray modelData = resourceFile.readAll();
-            resourceFile.close();
-
-            // 使用内存数据创建会话
-            try {
-                session_ = std::make_shared<Ort::Session>(
-                    env,
-                    reinterpret_cast<const void*>(modelData.constData()),
-                    static_cast<size_t>(modelData.size()),
-                    session_options);
-            } catch (const Ort::Exception& e) {
-                LOG_WARN("Failed to create session with current configuration: {}. Retrying with CPU-only configuration.", e.what());
-                
-                // 重置会话选项，移除所有CUDA相关配置
-                session_options = Ort::SessionOptions{};
-                session_options.SetIntraOpNumThreads(2);
-                session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-                session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-                session_options.EnableCpuMemArena();
-                session_options.DisableMemPattern();
-                
-                // 重新尝试创建会话（仅使用CPU）
-                session_ = std::make_shared<Ort::Session>(
-                    env,
-                    reinterpret_cast<const void*>(modelData.constData()),
-                    static_cast<size_t>(modelData.size()),
-                    session_options);
-                
-                LOG_INFO("Successfully created session with CPU-only configuration.");
-            }
-        } else {
-            // 从文件系统加载（保留原有代码的兼容性）
-            //LOG_INFO("从文件系统加载眼睛模型: {}", actual_model_path);
-
-            // if (!file_exists(actual_model_path)) {
-            //     LOG_ERROR("错误：模型文件不存在: {}", actual_model_path);
-            //     return;
-            // }
-
-            // 转换为宽字符路径
-            std::wstring wmodel_path = utf8_to_wstring(actual_model_path);
-
-            // 创建会话
-            try {
-                session_ = std::make_shared<Ort::Session>(env, wmodel_path.c_str(), session_options);
-            } catch (const Ort::Exception& e) {
-                LOG_WARN("Failed to create session with current configuration: {}. Retrying with CPU-only configuration.", e.what());
-                
-                // 重置会话选项，移除所有CUDA相关配置
-                session_options = Ort::SessionOptions{};
-                session_options.SetIntraOpNumThreads(2);
-                session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-                session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
-                session_options.EnableCpuMemArena();
-                session_options.DisableMemPattern();
-                
-                // 重新尝试创建会话（仅使用CPU）
-                session_ = std::make_shared<Ort::Session>(env, wmodel_path.c_str(), session_options);
-                
-                LOG_INFO("Successfully created session with CPU-only configuration.");
-            }
+        try {
+            // 使用官方推荐的CUDA初始化方式
+            OrtCUDAProviderOptionsV2* cuda_options = nullptr;
+            Ort::ThrowOnError(Ort::GetApi().CreateCUDAProviderOptions(&cuda_options));
+            
+            std::vector<const char*> keys{"device_id", "gpu_mem_limit", "arena_extend_strategy", 
+                                         "cudnn_conv_algo_search", "do_copy_in_default_stream", 
+                                         "cudnn_conv_use_max_workspace", "cudnn_conv1d_pad_to_nc1d",
+                                         "enable_cuda_graph"};
+            std::vector<const char*> values{"0", "4294967296", "kNextPowerOfTwo", 
+                                           "EXHAUSTIVE", "1", "1", "1", "0"};
+            
+            Ort::ThrowOnError(Ort::GetApi().UpdateCUDAProviderOptions(cuda_options, keys.data(), values.data(), keys.size()));
+            
+            // 添加CUDA执行提供者
+            Ort::ThrowOnError(Ort::GetApi().SessionOptionsAppendExecutionProvider_CUDA_V2(
+                static_cast<OrtSessionOptions*>(session_options), cuda_options));
+            
+            // 释放提供者选项
+            Ort::GetApi().ReleaseCUDAProviderOptions(cuda_options);
+            LOG_INFO("CUDA execution provider successfully configured for face inference.");
+        } catch (const Ort::Exception& e) {
+            LOG_WARN("Failed to configure CUDA execution provider: {}. Falling back to CPU.", e.what());
+            cuda_is_available = false;
+        } catch (const std::exception& e) {
+            LOG_WARN("Failed to configure CUDA execution provider: {}. Falling back to CPU.", e.what());
+            cuda_is_available = false;
         }
+    }
+    
+    // 默认的CPU执行提供者会自动添加，XNNPACK 等需要显式追加
+    ExecutionProvider cpu_provider = ExecutionProvider::Cpu;
+    if (!cuda_is_available) {
+        cpu_provider = append_execution_provider(session_options, execution_provider_);
+        LOG_INFO("Using {} execution provider for face inference.", execution_provider_name(cpu_provider));
+    }
 
-        io_binding_ = std::make_shared<Ort::IoBinding>(*session_);
+    // 从注册表获取共享会话，同一模型只加载一次
+    auto& registry = ModelRegistry::instance();
+    SessionRequest request;
+    request.model_path = actual_model_path;
+    request.fallback_path = embedded_model_path;
+    request.options_tag = cuda_is_available ? "face_cuda" : std::string("face_") + execution_provider_name(cpu_provider);
+    // CUDA 会话的优化结果和耗时都依赖设备，只缓存和测试 CPU 会话
+    // 其它执行提供者会把子图编译为无法保存的节点，只缓存默认 CPU 执行提供者的会话
+    request.use_cache = !cuda_is_available && cpu_provider == ExecutionProvider::Cpu;
+    request.auto_tune = !cuda_is_available;
+    request.default_tuning.intra_op_threads = 1;  // 对于GPU推理，减少CPU线程数
+    request.uint8_input = uint8_input_;
+    try {
+        return registry.acquire_session(request, session_options);
+    } catch (const Ort::Exception& e) {
+        LOG_WARN("Failed to create session with current configuration: {}. Retrying with CPU-only configuration.", e.what());
 
-        // 初始化输入和输出名称
-        init_io_names();
+        // 重置会话选项，移除所有CUDA相关配置
+        session_options = Ort::SessionOptions{};
+        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        session_options.EnableCpuMemArena();
 
-        // 提前分配内存
-        allocate_buffers();
+        request.options_tag = "face_cpu_fallback";
+        request.use_cache = true;
+        request.auto_tune = true;
+        request.default_tuning.intra_op_threads = 2;
 
-        LOG_INFO("模型加载完成");
-    } catch (const Ort::Exception& e) {
-        LOG_ERROR("ONNX Runtime 错误: {}", e.what());
-    } catch (const std::exception& e) {
-        LOG_ERROR("标准异常: {}", e.what());
+        // 重新尝试创建会话（仅使用CPU）
+        auto session = registry.acquire_session(request, session_options);
+        LOG_INFO("Successfully created session with CPU-only configuration.");
+        return session;
     }
 }
+
+FaceInference::~FaceInference()
+{
+    // 后台加载会调用 create_session，必须在派生类析构前结束
+    wait_for_reload();
+}
+
 void FaceInference::inference(cv::Mat image) {
-    if (!image.empty()) {
+    // 后台加载的新模型在这里切换
+    adopt_pending_model();
+    if (!model_) {
+        return;
+    }
+    // 画面没有变化时沿用上一次的模型输出，get_output 仍会推进滤波
+    if (!image.empty() && frame_changed(image)) {
+        // 开启级联时按画面运动选择小模型或完整模型
+        select_cascade_model(frame_motion());
         // 预处理图像 - 直接修改预分配的内存
-        preprocess(image);
+        {
+            StageTimer timer(stage_timing_, stage_timings_.preprocess_ms);
+            preprocess(image);
+        }
         // 运行模型
-        run_model();
+        {
+            StageTimer timer(stage_timing_, stage_timings_.run_model_ms);
+            run_model();
+        }
         // 处理结果
         process_results();
     }
 }
 
 void FaceInference::preprocess(const cv::Mat& input) {
-    // 转换为灰度图（如果需要）
-    if (input.channels() == 3 && input_c_ == 1) {
-        cv::cvtColor(input, gray_image_, cv::COLOR_BGR2GRAY);
-    } else if (input.channels() == 1 && input_c_ == 3) {
-        cv::cvtColor(input, gray_image_, cv::COLOR_GRAY2BGR);
-    } else {
-        gray_image_ = input;
-    }
-    // 调整大小
-    cv::resize(gray_image_, processed_image_, cv::Size(input_w_, input_h_), cv::INTER_NEAREST);
-    // 归一化处理 - 避免不必要的数据复制
-    processed_image_.convertTo(processed_image_, CV_32F, 1.0/255.0);
-    // 直接拷贝到输入数据缓冲区
-    if (processed_image_.isContinuous()) {
-        std::memcpy(input_data_.data(), processed_image_.ptr<float>(),
-                   processed_image_.total() * sizeof(float));
-    } else {
-        // 如果数据不连续，则逐行拷贝
-        size_t row_bytes = processed_image_.cols * processed_image_.elemSize();
-        for (int i = 0; i < processed_image_.rows; ++i) {
-            std::memcpy(input_data_.data() + i * processed_image_.cols,
-                       processed_image_.ptr(i), row_bytes);
-        }
-    }
-}
-
-void FaceInference::run_model() {
-    if (!session_ || input_name_ptrs_.empty() || output_name_ptrs_.empty()) {
-        return;
-    }
-
-    try {
-        // 创建输入张量 - 使用预分配的内存
-        input_tensor_ = Ort::Value::CreateTensor<float>(
-            memory_info_,
-            input_data_.data(),
-            input_data_.size(),
-            input_shapes_[0].data(),
-            input_shapes_[0].size()
-        );
-
-        // 绑定输入
-        io_binding_->BindInput(input_name_ptrs_[0], input_tensor_);
-        // 绑定输出
-        for (size_t i = 0; i < output_name_ptrs_.size(); i++) {
-            io_binding_->BindOutput(output_name_ptrs_[i], memory_info_);
-        }
-        // 运行推理
-        session_->Run(Ort::RunOptions{nullptr}, *io_binding_);
-        // 获取输出
-        output_tensors_ = io_binding_->GetOutputValues();
-    } catch (const std::exception& e) {
-        LOG_ERROR("推理错误: {}", e.what());
-    }
+    // 直接写入输入缓冲区，按模型输入类型写入 float 或 uint8
+    write_input(input);
 }
 
 void FaceInference::process_results() {
-    if (output_tensors_.empty()) {
-        return;
-    }
-
-    // 处理第一个输出
-    try {
-        Ort::Value& output_tensor = output_tensors_.front();
-        // 获取输出形状
-        auto shape_info = output_tensor.GetTensorTypeAndShapeInfo();
-        auto output_shape = shape_info.GetShape();
-
-        // 计算输出大小
-        size_t output_size = 1;
-        for (auto dim : output_shape) {
-            output_size *= dim;
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR("处理结果出错: {}", e.what());
-    }
+    // 输出已直接写入绑定的缓冲区，无需额外处理
 }
 
-std::vector<float> FaceInference::get_output()
+std::span<const float> FaceInference::get_output()
 {
-    if (output_tensors_.empty()) {
-        return std::vector<float>();
+    size_t output_size = 0;
+    const float* output_data = first_output(output_size);
+    if (output_data == nullptr) {
+        return {};
     }
 
     try {
-        // 获取第一个输出张量
-        const Ort::Value& output_tensor = output_tensors_.front();
-        const float* output_data = output_tensor.GetTensorData<float>();
-
-        // 获取输出形状
-        auto shape_info = output_tensor.GetTensorTypeAndShapeInfo();
-        auto output_shape = shape_info.GetShape();
-
-        // 计算输出大小
-        size_t output_size = 1;
-        for (auto dim : output_shape) {
-            output_size *= dim;
-        }
-        // 复制数据到结果向量
-        std::vector<float> result(output_data, output_data + output_size);
-        result.resize(90);
+        // 复制数据到预分配的结果缓冲区
+        std::fill(result_.begin(), result_.end(), 0.0f);
+        std::copy_n(output_data, std::min(output_size, result_.size()), result_.begin());
 
         if (use_filter)
         {
+            StageTimer timer(stage_timing_, stage_timings_.filter_ms);
 #ifdef DEBUG
-            float raw = 0;
-            if (!result.empty())
+            float raw = result_[4];
+#endif
+            if (adopt_filter_settings())
             {
-                raw = result[4];
+                init_output_filter();
             }
-#endif
             if (last_use_filter != use_filter)
             {
                 last_use_filter = use_filter;
-                cv::Mat input = cv::Mat(cv::Size(1, 90), CV_32F, result.data());
-                kalman_filter_.set_state(input.clone());
+                output_filter_.reset();
+                latency_predictor_.reset();
             }
-            auto temp = kalman_filter_.predict();
-            if (!result.empty())
-            {
-                auto measure = cv::Mat(cv::Size(1, 45), CV_32F, result.data());
-                kalman_filter_.correct(measure.clone());
-                result = kalman_filter_.state_post_.clone();
-            } else
+            output_filter_.apply(result_, filter_step());
+            if (latency_predictor_.enabled())
             {
-                result = temp.clone();
+                // 按测得的延迟沿滤波器速度外推
+                output_filter_.velocities(velocity_buffer_);
+                latency_predictor_.apply(result_, velocity_buffer_, dt, latency_predictor_.horizon(pipeline_latency_));
             }
 #ifdef DEBUG
-            if (!result.empty())
-            {
-                float filtered = result[4];
-                plot_curve(raw, filtered);
-            }
+            float filtered = result_[4];
+            plot_curve(raw, filtered);
 #endif
         }
-        result.resize(45);
+        std::span<float> result(result_.data(), kBlendShapeCount);
         // 输出限幅以及增益调整
-        // 应用偏置值 - 在这里添加代码
-        for (int i = 0; i < blendShapes.size() && i < result.size(); i++)
-        {
-            if (blendShapeOffsetMap.contains(blendShapes[i]))
-            {
-                // 应用偏置值，确保结果在0-1之间
-                result[i] = std::max(0.0f, std::min(1.0f, result[i] + blendShapeOffsetMap[blendShapes[i]]));
-            }
-        }
-
-        AmpMapToOutput(result);
-
+        apply_output_transform(result);
 
         return result;
     }
     catch (const std::exception& e) {
         LOG_ERROR("获取输出数据错误: {}", e.what());
-        return std::vector<float>();
+        return {};
     }
 }
 
-void FaceInference::init_kalman_filter()
+void FaceInference::init_output_filter()
 {
-    int pos_size = 45;
-    int state_size = pos_size * 2;  // 状态向量扩展为 [位置, 速度]
-
-    // 初始化协方差矩阵 P，状态维度为 90
-    cv::Mat P = cv::Mat::eye(state_size, state_size, CV_32F) * 1.0f;
-
-    // 过程噪声 Q：这里采用常数速度模型的过程噪声，使用 dt 的多项式因子
-    auto update_Q = [state_size, pos_size, this]() {
-        cv::Mat Q = cv::Mat::zeros(state_size, state_size, CV_32F);
-        float dt2 = dt * dt;
-        float dt3 = dt2 * dt;
-        float dt4 = dt3 * dt;
-        cv::Mat I_pos = cv::Mat::eye(pos_size, pos_size, CV_32F);
-
-        // 位置部分：dt^4/4 * q_factor^2
-        Q(cv::Rect(0, 0, pos_size, pos_size)) = I_pos * (dt4 / 4.0f * q_factor * q_factor);
-
-        // 位置-速度 交叉项：dt^3/2 * q_factor^2
-        Q(cv::Rect(pos_size, 0, pos_size, pos_size)) = I_pos * (dt3 / 2.0f * q_factor * q_factor);
-        Q(cv::Rect(0, pos_size, pos_size, pos_size)) = I_pos * (dt3 / 2.0f * q_factor * q_factor);
-
-        // 速度部分：dt^2 * q_factor^2
-        Q(cv::Rect(pos_size, pos_size, pos_size, pos_size)) = I_pos * (dt2 * q_factor * q_factor);
-
-        return Q;
-    };
-
-    // 测量噪声 R：假设测量仅包含位置部分，尺寸为 45x45
-    auto update_R = [pos_size, this](const cv::Mat& measurement) {
-        return cv::Mat::eye(pos_size, pos_size, CV_32F) * r_factor;
-    };
-
-    // 定义状态转移矩阵 F = [ I, dt*I; 0, I ]
-    auto TransMat = [state_size, pos_size, this](const cv::Mat& state) {
-        cv::Mat F = cv::Mat::eye(state_size, state_size, CV_32F);
-        cv::Mat I_pos = cv::Mat::eye(pos_size, pos_size, CV_32F);
-        // 将上半部分右侧的子矩阵设为 dt * I，即位置更新依赖于速度
-        F(cv::Rect(pos_size, 0, pos_size, pos_size)) = I_pos * dt;
-
-        return F;
-    };
-
-    // 定义测量矩阵函数 H = [ I, 0 ]，只观测位置部分
-    auto MeasureMat = [pos_size, state_size](const cv::Mat& state) {
-        cv::Mat H = cv::Mat::zeros(pos_size, state_size, CV_32F);
-        cv::Mat I_pos = cv::Mat::eye(pos_size, pos_size, CV_32F);
-        I_pos.copyTo(H(cv::Rect(0, 0, pos_size, pos_size)));
-        return H;
-    };
-
-    kalman_filter_ = KalmanFilter(TransMat, MeasureMat, update_Q, update_R, P.clone());
+    // 按 ARKit 名称前缀分组，如 jawOpen 属于 jaw 组
+    std::vector<std::string> groups;
+    groups.reserve(blendShapes.size());
+    for (const auto& name : blendShapes) {
+        groups.push_back(blendshape_group(name));
+    }
+    output_filter_.configure(groups, filter_settings_);
+    latency_predictor_.configure(filter_settings_.prediction, groups.size());
+    // 面捕输出均在 0-1 之间
+    latency_predictor_.set_range(0.0f, 1.0f);
+    velocity_buffer_.assign(groups.size(), 0.0f);
 }
 
 void FaceInference::initBlendShapeIndexMap()
 {
-    // 定义所有ARKit模型输出名称及其索引
-    blendShapes = {
-        "cheekPuffLeft", "cheekPuffRight",
-        "cheekSuckLeft", "cheekSuckRight",
-        "jawOpen", "jawForward", "jawLeft", "jawRight",
-        "noseSneerLeft", "noseSneerRight",
-        "mouthFunnel", "mouthPucker",
-        "mouthLeft", "mouthRight",
-        "mouthRollUpper", "mouthRollLower",
-        "mouthShrugUpper", "mouthShrugLower",
-        "mouthClose",
-        "mouthSmileLeft", "mouthSmileRight",
-        "mouthFrownLeft", "mouthFrownRight",
-        "mouthDimpleLeft", "mouthDimpleRight",
-        "mouthUpperUpLeft", "mouthUpperUpRight",
-        "mouthLowerDownLeft", "mouthLowerDownRight",
-        "mouthPressLeft", "mouthPressRight",
-        "mouthStretchLeft", "mouthStretchRight",
-        "tongueOut", "tongueUp", "tongueDown",
-        "tongueLeft", "tongueRight",
-        "tongueRoll", "tongueBendDown",
-        "tongueCurlUp", "tongueSquish",
-        "tongueFlat", "tongueTwistLeft",
-        "tongueTwistRight"
-    };
-
-    // 构建映射
-    for (size_t i = 0; i < blendShapes.size(); ++i) {
-        blendShapeIndexMap[blendShapes[i]] = i;
-        blendShapeAmpMap.insert_or_assign(blendShapes[i], 0);
+    // 名称和顺序取自 blendshape_schema.hpp
+    blendShapes.clear();
+    blendShapes.reserve(kBlendShapeCount);
+    for (const auto& info : kBlendShapeSchema) {
+        blendShapeIndexMap[std::string(info.name)] = index_of(info.shape);
+        blendShapes.emplace_back(info.name);
     }
+    publish_output_transform();
 }
 
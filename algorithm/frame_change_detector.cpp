@@ -0,0 +1,58 @@
+//
+// Created by JellyfishKnight on 25-7-10.
+//
+#include "frame_change_detector.hpp"
+#include <algorithm>
+#include <utility>
+#include <opencv2/imgproc.hpp>
+
+void FrameChangeDetector::configure(const ChangeGateConfig& config)
+{
+    config_ = config;
+    config_.sample_size = std::max(config_.sample_size, 4);
+    config_.max_skip = std::max(config_.max_skip, 0);
+    reset();
+}
+
+void FrameChangeDetector::reset()
+{
+    has_reference_ = false;
+    skipped_in_row_ = 0;
+}
+
+bool FrameChangeDetector::changed(const cv::Mat& image)
+{
+    stats_.frames++;
+    if ((!config_.enabled && !measure_) || image.empty()) {
+        return true;
+    }
+
+    // 先缩小再转灰度，颜色转换只处理缩略图
+    const cv::Size size(config_.sample_size, config_.sample_size);
+    if (image.channels() == 1) {
+        cv::resize(image, sample_, size, 0, 0, cv::INTER_AREA);
+    } else {
+        cv::resize(image, resized_, size, 0, 0, cv::INTER_AREA);
+        cv::cvtColor(resized_, sample_, image.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    }
+
+    last_difference_ = 0;
+    if (has_reference_) {
+        last_difference_ = static_cast<float>(cv::norm(sample_, reference_, cv::NORM_L1) / static_cast<double>(sample_.total()));
+        if (config_.enabled && skipped_in_row_ < config_.max_skip && last_difference_ < config_.threshold) {
+            skipped_in_row_++;
+            stats_.skipped++;
+            return false;
+        }
+    }
+    // 参考帧始终是上一次推理的画面，缓慢变化会逐渐累积直到超过阈值
+    std::swap(sample_, reference_);
+    has_reference_ = true;
+    skipped_in_row_ = 0;
+    return true;
+}
+
+ChangeGateStats FrameChangeDetector::take_stats()
+{
+    return std::exchange(stats_, ChangeGateStats{});
+}
@@ -0,0 +1,319 @@
+//
+// Created by JellyfishKnight on 25-7-3.
+//
+#include "fused_preprocess.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FUSED_PREPROCESS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FUSED_TARGET_AVX2
+#else
+#define FUSED_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+    // 与 OpenCV BGR2GRAY 的 8 位定点实现一致（Q14）
+    constexpr int kB2Y = 1868;
+    constexpr int kG2Y = 9617;
+    constexpr int kR2Y = 4899;
+    constexpr int kShift = 14;
+    constexpr int kRound = 1 << (kShift - 1);
+    // convertTo 内部把缩放系数转换为 float 后再相乘
+    const float kScale = static_cast<float>(1.0 / 255.0);
+
+    inline int bgr_to_gray(const uchar* p)
+    {
+        return (p[0] * kB2Y + p[1] * kG2Y + p[2] * kR2Y + kRound) >> kShift;
+    }
+
+    void bgr_row_scalar(const uchar* row, const int* x_ofs, const float* lut, float* out, int begin, int end)
+    {
+        for (int x = begin; x < end; x++) {
+            out[x] = lut[bgr_to_gray(row + x_ofs[x])];
+        }
+    }
+
+    void bgr_row_scalar(const uchar* row, const int* x_ofs, uchar* out, int begin, int end)
+    {
+        for (int x = begin; x < end; x++) {
+            out[x] = static_cast<uchar>(bgr_to_gray(row + x_ofs[x]));
+        }
+    }
+
+#ifdef FUSED_PREPROCESS_X86
+    // 每个 32 位通道按两个 int16 做乘加：(b, r) * (B2Y, R2Y) + (g, 1) * (G2Y, round)
+    inline __m128i gray4_sse2(const uchar* row, const int* x_ofs)
+    {
+        const __m128i br_coef = _mm_set1_epi32((kR2Y << 16) | kB2Y);
+        const __m128i g_coef = _mm_set1_epi32((kRound << 16) | kG2Y);
+        const __m128i mask_br = _mm_set1_epi32(0x00ff00ff);
+        const __m128i mask_g = _mm_set1_epi32(0xff);
+        const __m128i one_hi = _mm_set1_epi32(0x00010000);
+        int32_t px[4];
+        std::memcpy(&px[0], row + x_ofs[0], 4);
+        std::memcpy(&px[1], row + x_ofs[1], 4);
+        std::memcpy(&px[2], row + x_ofs[2], 4);
+        std::memcpy(&px[3], row + x_ofs[3], 4);
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px));
+        __m128i br = _mm_and_si128(p, mask_br);
+        __m128i g1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 8), mask_g), one_hi);
+        __m128i sum = _mm_add_epi32(_mm_madd_epi16(br, br_coef), _mm_madd_epi16(g1, g_coef));
+        return _mm_srli_epi32(sum, kShift);
+    }
+
+    int bgr_row_sse2(const uchar* row, const int* x_ofs, float* out, int count)
+    {
+        const __m128 scale = _mm_set1_ps(kScale);
+        int x = 0;
+        for (; x + 4 <= count; x += 4) {
+            __m128i gray = gray4_sse2(row, x_ofs + x);
+            _mm_storeu_ps(out + x, _mm_mul_ps(_mm_cvtepi32_ps(gray), scale));
+        }
+        return x;
+    }
+
+    int bgr_row_sse2(const uchar* row, const int* x_ofs, uchar* out, int count)
+    {
+        int x = 0;
+        for (; x + 4 <= count; x += 4) {
+            __m128i gray = gray4_sse2(row, x_ofs + x);
+            // 灰度值不超过 255，两次饱和打包后低 4 字节即为结果
+            __m128i words = _mm_packs_epi32(gray, gray);
+            __m128i packed = _mm_packus_epi16(words, words);
+            int32_t bytes = _mm_cvtsi128_si32(packed);
+            std::memcpy(out + x, &bytes, 4);
+        }
+        return x;
+    }
+
+    FUSED_TARGET_AVX2
+    inline __m256i gray8_avx2(const uchar* row, const int* x_ofs)
+    {
+        const __m256i br_coef = _mm256_set1_epi32((kR2Y << 16) | kB2Y);
+        const __m256i g_coef = _mm256_set1_epi32((kRound << 16) | kG2Y);
+        const __m256i mask_br = _mm256_set1_epi32(0x00ff00ff);
+        const __m256i mask_g = _mm256_set1_epi32(0xff);
+        const __m256i one_hi = _mm256_set1_epi32(0x00010000);
+        const int* base = reinterpret_cast<const int*>(row);
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x_ofs));
+        __m256i p = _mm256_i32gather_epi32(base, idx, 1);
+        __m256i br = _mm256_and_si256(p, mask_br);
+        __m256i g1 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask_g), one_hi);
+        __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(br, br_coef), _mm256_madd_epi16(g1, g_coef));
+        return _mm256_srli_epi32(sum, kShift);
+    }
+
+    FUSED_TARGET_AVX2
+    int bgr_row_avx2(const uchar* row, const int* x_ofs, float* out, int count)
+    {
+        const __m256 scale = _mm256_set1_ps(kScale);
+        int x = 0;
+        for (; x + 8 <= count; x += 8) {
+            __m256i gray = gray8_avx2(row, x_ofs + x);
+            _mm256_storeu_ps(out + x, _mm256_mul_ps(_mm256_cvtepi32_ps(gray), scale));
+        }
+        return x;
+    }
+
+    FUSED_TARGET_AVX2
+    int bgr_row_avx2(const uchar* row, const int* x_ofs, uchar* out, int count)
+    {
+        int x = 0;
+        for (; x + 8 <= count; x += 8) {
+            __m256i gray = gray8_avx2(row, x_ofs + x);
+            // 打包在每个 128 位通道内进行，两个通道的低 4 字节分别是前后 4 个像素
+            __m256i words = _mm256_packs_epi32(gray, gray);
+            __m256i packed = _mm256_packus_epi16(words, words);
+            int32_t lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+            int32_t hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+            std::memcpy(out + x, &lo, 4);
+            std::memcpy(out + x + 4, &hi, 4);
+        }
+        return x;
+    }
+
+    bool cpu_has_avx2()
+    {
+#if defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        // 需要操作系统保存 YMM 寄存器
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    const bool kUseAvx2 = cpu_has_avx2();
+#endif
+}
+
+FusedPreprocessor::FusedPreprocessor() : FusedPreprocessor(best_backend())
+{
+}
+
+FusedPreprocessor::FusedPreprocessor(Backend backend)
+    : backend_(supports(backend) ? backend : best_backend())
+{
+    for (int v = 0; v < 256; v++) {
+        lut_[v] = static_cast<float>(v) * kScale;
+    }
+}
+
+const char* FusedPreprocessor::backend()
+{
+    return backend_name(best_backend());
+}
+
+const char* FusedPreprocessor::backend_name(Backend backend)
+{
+    switch (backend) {
+    case Backend::Avx2: return "avx2";
+    case Backend::Sse2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+FusedPreprocessor::Backend FusedPreprocessor::best_backend()
+{
+#ifdef FUSED_PREPROCESS_X86
+    return kUseAvx2 ? Backend::Avx2 : Backend::Sse2;
+#else
+    return Backend::Scalar;
+#endif
+}
+
+bool FusedPreprocessor::supports(Backend backend)
+{
+    switch (backend) {
+#ifdef FUSED_PREPROCESS_X86
+    case Backend::Avx2: return kUseAvx2;
+    case Backend::Sse2: return true;
+#endif
+    case Backend::Scalar: return true;
+    default: return false;
+    }
+}
+
+void FusedPreprocessor::update_tables(int src_w, int src_h, int dst_w, int dst_h, int pix_size)
+{
+    // 与 cv::resize(INTER_NEAREST) 的坐标计算保持一致
+    double ifx = 1.0 / (static_cast<double>(dst_w) / src_w);
+    double ify = 1.0 / (static_cast<double>(dst_h) / src_h);
+
+    x_ofs_.resize(dst_w);
+    safe_cols_ = 0;
+    for (int x = 0; x < dst_w; x++) {
+        int sx = std::min(static_cast<int>(std::floor(x * ifx)), src_w - 1);
+        x_ofs_[x] = sx * pix_size;
+        // 偏移单调不减，满足条件的列总是前缀
+        if (x_ofs_[x] + 4 <= src_w * pix_size) {
+            safe_cols_ = x + 1;
+        }
+    }
+
+    y_ofs_.resize(dst_h);
+    for (int y = 0; y < dst_h; y++) {
+        y_ofs_[y] = std::min(static_cast<int>(std::floor(y * ify)), src_h - 1);
+    }
+
+    src_w_ = src_w;
+    src_h_ = src_h;
+    dst_w_ = dst_w;
+    dst_h_ = dst_h;
+    pix_size_ = pix_size;
+}
+
+bool FusedPreprocessor::prepare(const cv::Mat& src, const void* dst, int dst_w, int dst_h)
+{
+    if (src.empty() || dst == nullptr || dst_w <= 0 || dst_h <= 0 || src.depth() != CV_8U) {
+        return false;
+    }
+    const int pix_size = src.channels();
+    if (pix_size != 1 && pix_size != 3) {
+        return false;
+    }
+
+    if (src.cols != src_w_ || src.rows != src_h_ || dst_w != dst_w_ || dst_h != dst_h_ || pix_size != pix_size_) {
+        update_tables(src.cols, src.rows, dst_w, dst_h, pix_size);
+    }
+    return true;
+}
+
+bool FusedPreprocessor::run(const cv::Mat& src, float* dst, int dst_w, int dst_h)
+{
+    if (!prepare(src, dst, dst_w, dst_h)) {
+        return false;
+    }
+
+    const int* x_ofs = x_ofs_.data();
+    const float* lut = lut_.data();
+    for (int y = 0; y < dst_h; y++) {
+        const uchar* row = src.ptr<uchar>(y_ofs_[y]);
+        float* out = dst + static_cast<size_t>(y) * dst_w;
+
+        if (pix_size_ == 1) {
+            for (int x = 0; x < dst_w; x++) {
+                out[x] = lut[row[x_ofs[x]]];
+            }
+            continue;
+        }
+
+        int x = 0;
+#ifdef FUSED_PREPROCESS_X86
+        // 向量路径每个像素读取 4 字节，行尾的列交给标量路径
+        if (backend_ == Backend::Avx2) {
+            x = bgr_row_avx2(row, x_ofs, out, safe_cols_);
+        } else if (backend_ == Backend::Sse2) {
+            x = bgr_row_sse2(row, x_ofs, out, safe_cols_);
+        }
+#endif
+        bgr_row_scalar(row, x_ofs, lut, out, x, dst_w);
+    }
+    return true;
+}
+
+bool FusedPreprocessor::run(const cv::Mat& src, uchar* dst, int dst_w, int dst_h)
+{
+    if (!prepare(src, dst, dst_w, dst_h)) {
+        return false;
+    }
+
+    const int* x_ofs = x_ofs_.data();
+    for (int y = 0; y < dst_h; y++) {
+        const uchar* row = src.ptr<uchar>(y_ofs_[y]);
+        uchar* out = dst + static_cast<size_t>(y) * dst_w;
+
+        if (pix_size_ == 1) {
+            for (int x = 0; x < dst_w; x++) {
+                out[x] = row[x_ofs[x]];
+            }
+            continue;
+        }
+
+        int x = 0;
+#ifdef FUSED_PREPROCESS_X86
+        if (backend_ == Backend::Avx2) {
+            x = bgr_row_avx2(row, x_ofs, out, safe_cols_);
+        } else if (backend_ == Backend::Sse2) {
+            x = bgr_row_sse2(row, x_ofs, out, safe_cols_);
+        }
+#endif
+        bgr_row_scalar(row, x_ofs, out, x, dst_w);
+    }
+    return true;
+}
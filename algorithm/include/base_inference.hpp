@@ -4,11 +4,22 @@
 
 #ifndef BASE_INFERENCE_HPP
 #define BASE_INFERENCE_HPP
+#include <atomic>
+#include <cascade_controller.hpp>
+#include <chrono>
+#include <execution_provider.hpp>
 #include <fstream>
-#include <kalman_filter.hpp>
+#include <frame_change_detector.hpp>
+#include <fused_preprocess.hpp>
 #include <opencv2/core.hpp>
 #include <onnxruntime_cxx_api.h>
+#include <output_filter.hpp>
+#include <output_transform.hpp>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <thread>
 
 inline bool file_exists(const std::string& path) {
     std::ifstream file(path);
@@ -21,19 +32,69 @@ inline std::wstring utf8_to_wstring(const std::string& str) {
     return result;
 }
 
+// 与一个模型会话绑定的全部推理资源
+// 可以在后台线程完整构建并预热，再整体交给推理线程，推理线程之外不会访问正在使用的实例
+struct ModelInstance
+{
+    std::string model_path;
+    std::shared_ptr<Ort::Session> session;
+    std::shared_ptr<Ort::IoBinding> io_binding;
+
+    // 输入输出名称
+    std::vector<std::string> input_names;
+    std::vector<std::string> output_names;
+    std::vector<const char*> input_name_ptrs;
+    std::vector<const char*> output_name_ptrs;
+
+    // 输入形状，动态维度已按批次大小固定
+    std::vector<std::vector<int64_t>> input_shapes;
+    int batch_size = 1;
+    int input_h = 0;
+    int input_w = 0;
+    int input_c = 0;
+
+    // ONNX Runtime资源
+    Ort::MemoryInfo memory_info{nullptr};
+    Ort::Value input_tensor{nullptr};
+    std::vector<Ort::Value> output_tensors;
+    std::vector<float> input_data; // 输入数据缓冲区
+    // 模型输入为 uint8 时使用字节缓冲区，归一化在图内完成，input_data 为空
+    bool uint8_input = false;
+    std::vector<uint8_t> input_bytes;
+    std::vector<std::vector<float>> output_data; // 输出数据缓冲区，与 output_tensors 一一对应
+    bool outputs_preallocated = false; // 输出形状固定时绑定到预分配缓冲区，否则由 ORT 分配
+};
+
+// 单帧各阶段耗时（毫秒），开启统计后在推理和取结果时累加
+struct StageTimings
+{
+    double preprocess_ms = 0;
+    double run_model_ms = 0;
+    double filter_ms = 0;   // 输出滤波
+};
+
 class BaseInference
 {
 public:
-    virtual ~BaseInference() = default;
+    virtual ~BaseInference();
 
     virtual void inference(cv::Mat image) = 0;
 
-    virtual void load_model(const std::string &model_path) = 0;
+    // 同步加载模型，加载并预热完成后立即生效，需在推理线程中调用
+    void load_model(const std::string &model_path);
+
+    // 在后台线程加载并预热新模型，完成后推理线程在下一帧切换，切换前继续使用当前模型
+    // 新模型输入批次与当前模型不一致时放弃切换
+    void reload_model_async(const std::string &model_path);
 
-    virtual std::vector<float> get_output() = 0;
+    // 返回指向内部预分配缓冲区的视图，在下一次 inference/get_output 调用前有效
+    virtual std::span<const float> get_output() = 0;
 
+    // 增益和偏置可在界面线程调用，重新编译为逐通道变换后原子发布，推理线程在下一帧生效
     void set_amp_map(const std::unordered_map<std::string, int>& amp_map);
 
+    void set_offset_map(const std::unordered_map<std::string, float>& offset_map);
+
     const std::unordered_map<std::string, size_t>& getBlendShapeIndexMap();
 
     void set_use_filter(bool use);
@@ -45,14 +106,106 @@ public:
     void set_r_factor(float factor);
 
     bool use_filter_status() const;
+
+    // 设置各分组的滤波方式，可在任意线程调用，推理线程在下一帧取结果时生效
+    // 延迟补偿沿滤波器估计的速度外推，只在 use_filter 开启时生效，开启补偿但关闭滤波时打印警告
+    void set_output_filter(const OutputFilterSettings& settings);
+
+    // 设置帧差门控，可在任意线程调用，推理线程在下一帧生效
+    void set_change_gate(const ChangeGateConfig& config);
+
+    // 返回自上次调用以来各槽位合计的跳帧统计并清零，需在推理线程中调用
+    ChangeGateStats take_change_gate_stats();
+
+    // 让模型直接接收 uint8 输入，需在 load_model 之前调用
+    // 加载时在图中插入 Cast 和 Mul 完成归一化，模型无法改写时自动使用 float 输入
+    void set_uint8_input(bool enable);
+
+    // 设置执行提供者，需在 load_model 之前调用，不可用或会话创建失败时使用默认 CPU 执行提供者
+    void set_execution_provider(const ExecutionProviderConfig& config);
+
+    // 设置级联推理，需在 load_model 之前调用，加载完整模型后同时加载小模型
+    void set_cascade(const CascadeConfig& config);
+
+    // 返回自上次调用以来完整模型和小模型各自的推理帧数并清零，需在推理线程中调用
+    CascadeStats take_cascade_stats();
+
+    // 当前帧从接收到现在经过的秒数，开启延迟补偿时在 get_output 前设置
+    void set_pipeline_latency(double seconds);
+
+    // 模型加载并预热完成后为 true，界面和推理线程据此判断是否可以推理
+    bool is_ready() const;
+
+    // 开启后记录各阶段耗时，默认关闭，关闭时不读取时钟
+    void set_stage_timing(bool enable);
+
+    // 返回自上次调用以来累计的各阶段耗时并清零
+    StageTimings take_stage_timings();
 protected:
-    virtual void init_kalman_filter() = 0;
+    // 开启统计时把作用域内的耗时累加到 target
+    class StageTimer
+    {
+    public:
+        StageTimer(bool enabled, double& target) : target_(enabled ? &target : nullptr)
+        {
+            if (target_ != nullptr) {
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~StageTimer()
+        {
+            if (target_ != nullptr) {
+                *target_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+            }
+        }
+
+    private:
+        double* target_;
+        std::chrono::steady_clock::time_point start_{};
+    };
+
+    // 按子类的会话配置创建会话，失败时抛出异常
+    virtual std::shared_ptr<Ort::Session> create_session(const std::string &model_path) = 0;
+
+    // 切换到新模型后调用，子类据此调整与批次相关的状态
+    virtual void on_model_changed() {}
+
+    // 每帧推理前调用，有新模型时切换到新模型，没有时只读取一次原子变量
+    void adopt_pending_model();
+
+    // 等待后台加载结束，子类析构时必须先调用
+    void wait_for_reload();
+
+    // 设置中开启了延迟补偿但 use_filter 关闭时打印警告
+    void warn_prediction_without_filter() const;
+
+    // 按 filter_settings_ 重建输出滤波器
+    virtual void init_output_filter() = 0;
+
+    // 有新的滤波设置时切换到新设置并返回 true，没有时只读取一次原子变量
+    bool adopt_filter_settings();
+
+    FilterStep filter_step() const { return FilterStep{dt, q_factor, r_factor}; }
+
+    // 指定槽位的画面相对上一次推理是否有变化，没有可用的模型输出时总是返回 true
+    bool frame_changed(const cv::Mat& image, int slot = 0);
+
+    // 指定槽位最近一次 frame_changed 测得的画面差异
+    float frame_motion(int slot = 0) const;
+
+    // 按画面运动和上一帧的输出选择本帧使用的模型，未开启级联时总是完整模型
+    // 返回 true 表示与上一次推理使用的模型不同，此时各槽位的输入需要重新写入
+    bool select_cascade_model(float motion);
 
     // 预处理图像
     virtual void preprocess(const cv::Mat& input) = 0;
 
-    // 运行模型
-    virtual void run_model() = 0;
+    // 把图像转换为模型输入并写入当前实例输入缓冲区的指定槽位，按实例的输入类型写入 float 或 uint8
+    void write_input(const cv::Mat& input, int slot = 0);
+
+    // 运行模型，输入输出已提前绑定到预分配缓冲区
+    virtual void run_model();
 
     // 处理结果
     virtual void process_results() = 0;
@@ -62,54 +215,103 @@ protected:
     // 初始化ARKit模型输出的映射表
     virtual void initBlendShapeIndexMap() = 0;
 
-    // 将原始数据放大增益
-    void AmpMapToOutput(std::vector<float>& output);
+    // 按当前的增益和偏置编译变换并发布
+    void publish_output_transform();
+
+    // 对输出应用偏置、增益和限幅，有新的变换时先切换，没有时只读取一次原子变量
+    void apply_output_transform(std::span<float> output);
+
+    // 创建会话并完成绑定和预热，失败时抛出异常
+    std::shared_ptr<ModelInstance> build_instance(const std::string &model_path);
 
     // 初始化输入输出名称
-    void init_io_names();
+    void init_io_names(ModelInstance& instance) const;
 
-    // 预分配所有缓冲区
-    void allocate_buffers();
+    // 预分配所有缓冲区，并将输入输出一次性绑定到这些缓冲区
+    void allocate_buffers(ModelInstance& instance) const;
 
+    // 用全零输入运行一次，提前完成 ORT 的延迟初始化
+    void warm_up(ModelInstance& instance) const;
 
-    // 会话和会话选项
-    std::shared_ptr<Ort::Session> session_;
-    Ort::SessionOptions session_options;
+    // 切换到指定模型实例
+    void use_instance(std::shared_ptr<ModelInstance> instance);
 
-    std::shared_ptr<Ort::IoBinding> io_binding_;
+    // 第一个输出的数据和元素数量，尚无推理结果时返回 nullptr
+    const float* first_output(size_t& count) const;
+
+    // 切换本帧预处理和推理使用的实例，输入尺寸随之改变
+    void set_active(ModelInstance* instance);
+
+    // 按级联设置加载小模型，失败时只使用完整模型
+    void load_fast_model();
 
-    // 输入输出名称
-    std::vector<std::string> input_names_;
-    std::vector<std::string> output_names_;
-    std::vector<const char*> input_name_ptrs_;
-    std::vector<const char*> output_name_ptrs_;
+
+    // 推理线程正在使用的模型实例，只在推理线程中读写
+    std::shared_ptr<ModelInstance> model_;
+    // 级联推理的小模型，未开启时为空
+    std::shared_ptr<ModelInstance> fast_model_;
+    // 本帧预处理和推理使用的实例，指向 model_ 或 fast_model_
+    ModelInstance* active_ = nullptr;
+    CascadeConfig cascade_config_;
+    CascadeController cascade_;
+    // 后台加载完成、等待切换的模型实例
+    std::atomic<std::shared_ptr<ModelInstance>> pending_model_;
+    std::atomic<bool> has_pending_model_{false};
+    std::atomic<bool> reloading_{false};
+    std::thread reload_thread_;
 
     // 保存ARKit模型输出的映射表
     std::unordered_map<std::string, size_t> blendShapeIndexMap;
-    std::unordered_map<std::string, int> blendShapeAmpMap;
     std::vector<std::string> blendShapes;
-
-    // 输入形状
-    std::vector<std::vector<int64_t>> input_shapes_;
-
-    // 输入尺寸
+    // 界面设置的增益和偏置，只在编译变换时读取
+    std::mutex transform_mutex_;
+    std::unordered_map<std::string, int> blendShapeAmpMap;
+    std::unordered_map<std::string, float> blendShapeOffsetMap;
+    // 推理线程使用的变换和等待切换的变换
+    std::shared_ptr<const OutputTransform> output_transform_;
+    std::atomic<std::shared_ptr<const OutputTransform>> pending_output_transform_;
+
+    // 请求把模型输入改为 uint8，子类创建会话时使用
+    bool uint8_input_ = false;
+    // 请求的执行提供者，子类创建会话时使用
+    ExecutionProviderConfig execution_provider_;
+
+    // 请求的批次大小，动态批次维度按此值固定
+    int requested_batch_size_ = 1;
+    // 当前模型实际的批次大小
+    int batch_size_ = 1;
+
+    // 输入尺寸，加载模型后与当前模型一致
     int input_h_{};
     int input_w_{};
     int input_c_{};
 
-    // ONNX Runtime资源
-    Ort::MemoryInfo memory_info_{nullptr};
-    Ort::Value input_tensor_{nullptr};
-    std::vector<Ort::Value> output_tensors_;
-    std::vector<float> input_data_; // 输入数据缓冲区
+    bool has_output_ = false;
+    bool stage_timing_ = false;
+    StageTimings stage_timings_;
+    std::atomic<bool> ready_{false};
 
     // 预分配的缓冲区
     cv::Mat gray_image_;           // 灰度转换缓冲区
     cv::Mat processed_image_;      // 预处理图像缓冲区
+    FusedPreprocessor fused_preprocessor_; // 单次遍历的预处理
 
     bool use_filter = false;
     bool last_use_filter = use_filter;
-    KalmanFilter kalman_filter_;
+    // 最近一次 set_output_filter 是否开启了延迟补偿，只用于配置检查
+    std::atomic<bool> prediction_requested_{false};
+    // 当前滤波设置和输出滤波器，只在推理线程中读写
+    OutputFilterSettings filter_settings_;
+    GroupedOutputFilter output_filter_;
+    std::atomic<std::shared_ptr<const OutputFilterSettings>> pending_filter_settings_;
+    // 各批次槽位的帧差门控，只在推理线程中读写
+    ChangeGateConfig change_gate_config_;
+    std::vector<FrameChangeDetector> change_detectors_;
+    std::atomic<std::shared_ptr<const ChangeGateConfig>> pending_change_gate_;
+    // 延迟补偿，速度取自输出滤波器
+    LatencyPredictor latency_predictor_;
+    std::vector<float> velocity_buffer_;
+    double pipeline_latency_ = 0;
     std::vector<float> raw_data;       // 存储原始数据
     std::vector<float> filtered_data;  // 存储滤波后数据
     int max_points = 200;        // 只保留最近 200 个点，防止图像过长
@@ -0,0 +1,65 @@
+//
+// Created by JellyfishKnight on 25-7-10.
+//
+
+#ifndef CASCADE_CONTROLLER_HPP
+#define CASCADE_CONTROLLER_HPP
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+// 级联推理参数，默认关闭
+struct CascadeConfig
+{
+    bool enabled = false;
+    // 小模型路径，输入输出格式需与完整模型一致，可以是更低的输入分辨率
+    std::string fast_model;
+    // 每隔多少帧强制运行一次完整模型作为关键帧
+    int keyframe_interval = 8;
+    // 画面平均绝对差（0-255 灰度）超过该值时使用完整模型
+    float motion_threshold = 6.0f;
+    // 小模型相邻两次输出的最大变化超过该值时，下一帧使用完整模型
+    float output_threshold = 0.1f;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(CascadeConfig, enabled, fast_model, keyframe_interval,
+                                                motion_threshold, output_threshold);
+};
+
+struct CascadeStats
+{
+    uint64_t full_frames = 0;
+    uint64_t fast_frames = 0;
+};
+
+// 决定每帧使用小模型还是完整模型
+// 画面运动大、小模型输出跳变（结果不可信）或到达关键帧间隔时使用完整模型，其余帧使用小模型
+class CascadeController
+{
+public:
+    void configure(const CascadeConfig& config);
+
+    // 清除历史，下一帧使用完整模型
+    void reset();
+
+    // motion 为本帧画面相对上一次推理的平均绝对差，返回 true 表示使用完整模型
+    bool want_full(float motion);
+
+    // 记录本帧模型输出，full 表示由完整模型产生
+    void observe(std::span<const float> output, bool full);
+
+    // 返回自上次调用以来的统计并清零
+    CascadeStats take_stats();
+
+private:
+    CascadeConfig config_;
+    std::vector<float> last_output_;
+    bool has_output_ = false;
+    bool escalate_ = true;
+    int frames_since_full_ = 0;
+    CascadeStats stats_;
+};
+
+#endif //CASCADE_CONTROLLER_HPP
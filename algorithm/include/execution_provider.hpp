@@ -0,0 +1,56 @@
+//
+// Created by JellyfishKnight on 25-7-11.
+//
+
+#ifndef EXECUTION_PROVIDER_HPP
+#define EXECUTION_PROVIDER_HPP
+
+#include <string>
+#include <vector>
+#include <json.hpp>
+#include <onnxruntime_cxx_api.h>
+
+// 推理使用的执行提供者
+enum class ExecutionProvider
+{
+    Auto,       // 面捕有 CUDA 时使用 CUDA，否则使用默认的 CPU 执行提供者
+    Cpu,        // ORT 默认的 CPU 执行提供者
+    Xnnpack,
+    Dnnl,       // oneDNN
+    OpenVino,   // OpenVINO 的 CPU 设备
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(ExecutionProvider, {
+    {ExecutionProvider::Auto, "auto"},
+    {ExecutionProvider::Cpu, "cpu"},
+    {ExecutionProvider::Xnnpack, "xnnpack"},
+    {ExecutionProvider::Dnnl, "dnnl"},
+    {ExecutionProvider::OpenVino, "openvino"},
+})
+
+// 单个模型的执行提供者设置
+struct ExecutionProviderConfig
+{
+    ExecutionProvider provider = ExecutionProvider::Auto;
+    // 执行提供者自己的线程数（XNNPACK、OpenVINO），0 使用其默认值
+    int threads = 0;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(ExecutionProviderConfig, provider, threads);
+};
+
+// 配置文件中使用的名称，如 "xnnpack"
+const char* execution_provider_name(ExecutionProvider provider);
+
+bool parse_execution_provider(const std::string& name, ExecutionProvider& provider);
+
+// 当前链接的 ORT 是否编译了该执行提供者，Auto 和 Cpu 总是可用
+bool execution_provider_available(ExecutionProvider provider);
+
+// 可用的 CPU 执行提供者，第一个总是 Cpu
+std::vector<ExecutionProvider> available_cpu_execution_providers();
+
+// 按配置把执行提供者追加到会话选项，未命中的算子仍由默认的 CPU 执行提供者执行
+// 返回实际使用的执行提供者；不可用或追加失败时返回 Cpu，Auto 也返回 Cpu，由调用者决定是否尝试 CUDA
+ExecutionProvider append_execution_provider(Ort::SessionOptions& options, const ExecutionProviderConfig& config);
+
+#endif //EXECUTION_PROVIDER_HPP
@@ -12,26 +12,51 @@
 class EyeInference : public BaseInference
 {
 public:
-    EyeInference();
+    // batch_size > 1 时启用批量模式，多只眼睛的图像堆叠成一个输入张量，一次Run完成推理
+    explicit EyeInference(int batch_size = 1);
 
-    virtual ~EyeInference() = default;
+    virtual ~EyeInference();
 
     void inference(cv::Mat image) override;
 
-    std::vector<float> get_output() override;
+    // 批量推理，images[i] 对应第 i 个批次槽位，空图像的槽位本帧不更新
+    void inference_batch(const std::vector<cv::Mat>& images);
 
-    void load_model(const std::string &model_path) override;
+    std::span<const float> get_output() override;
+
+    // 获取指定批次槽位的输出，每个槽位有独立的滤波器
+    std::span<const float> get_output(int slot);
+
+    // 模型加载后实际生效的批次大小，模型不支持动态批次时退回 1
+    int batch_size() const { return batch_size_; }
 
 protected:
-    void init_kalman_filter() override;
+    std::shared_ptr<Ort::Session> create_session(const std::string &model_path) override;
+
+    void on_model_changed() override;
+
+    void init_output_filter() override;
 
     void preprocess(const cv::Mat& input) override;
 
-    void run_model() override;
+    // 预处理图像到指定批次槽位的输入缓冲区
+    void preprocess(const cv::Mat& input, int slot);
 
     void process_results() override;
 
     void initBlendShapeIndexMap() override;
+
+private:
+    // 每个批次槽位独立的输出滤波器及其状态
+    std::vector<GroupedOutputFilter> slot_filters_;
+    std::vector<LatencyPredictor> slot_predictors_;
+    std::vector<bool> slot_last_use_filter_;
+    // 本帧各槽位是否有新的输入
+    std::vector<bool> slot_valid_;
+    // 本帧各槽位的画面是否有变化
+    std::vector<bool> slot_changed_;
+    // 各槽位预分配的输出结果
+    std::vector<std::vector<float>> slot_results_;
 };
 
 
@@ -6,7 +6,7 @@
 #define FaceInference_HPP
 
 #include "base_inference.hpp"
-#include "kalman_filter.hpp"
+#include <blendshape_schema.hpp>
 #include <memory>
 #include <vector>
 #include <opencv2/core.hpp>
@@ -18,30 +18,25 @@ class FaceInference final : public BaseInference {
 public:
     FaceInference();
 
-    virtual ~FaceInference() = default;
-    void set_offset_map(const std::unordered_map<std::string, float>& offset_map) {
-        blendShapeOffsetMap = offset_map;
-    }
-    // 加载模型
-    void load_model(const std::string &model_path) override;
-
+    virtual ~FaceInference();
     // 运行推理
     void inference(cv::Mat image) override;
 
-    std::vector<float> get_output() override;
+    std::span<const float> get_output() override;
 
 private:
-    void init_kalman_filter() override;
+    // 创建会话，CUDA 可用时优先使用 CUDA，失败后退回 CPU
+    std::shared_ptr<Ort::Session> create_session(const std::string &model_path) override;
+
+    void init_output_filter() override;
 
     // 预处理图像
     void preprocess(const cv::Mat& input) override;
 
-    // 运行模型
-    void run_model() override;
-
     // 处理结果
     void process_results() override;
-    std::unordered_map<std::string, float> blendShapeOffsetMap;
+    // 输出结果缓冲区
+    std::vector<float> result_;
     // 初始化ARKit模型输出的映射表
     void initBlendShapeIndexMap() override;
 };
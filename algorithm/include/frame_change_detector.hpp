@@ -0,0 +1,70 @@
+//
+// Created by JellyfishKnight on 25-7-10.
+//
+
+#ifndef FRAME_CHANGE_DETECTOR_HPP
+#define FRAME_CHANGE_DETECTOR_HPP
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <json.hpp>
+
+// 帧差门控参数
+struct ChangeGateConfig
+{
+    // 默认关闭，需在配置文件中开启：阈值与摄像头噪声有关，升级后的旧配置不应被静默跳帧
+    bool enabled = false;
+    // 缩略图逐像素平均绝对差（0-255 灰度）低于该值时视为画面未变化，沿用上一次的模型输出
+    float threshold = 1.0f;
+    // 连续跳过的最大帧数，达到后强制推理一次，避免缓慢变化一直被忽略
+    int max_skip = 30;
+    // 比较用缩略图的边长
+    int sample_size = 32;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(ChangeGateConfig, enabled, threshold, max_skip, sample_size);
+};
+
+// 跳帧统计
+struct ChangeGateStats
+{
+    uint64_t frames = 0;
+    uint64_t skipped = 0;
+
+    double skip_rate() const { return frames > 0 ? static_cast<double>(skipped) / static_cast<double>(frames) : 0.0; }
+};
+
+// 把输入缩小为灰度缩略图，与上一次推理时的缩略图比较平均绝对差
+// 缩放和求差都由 OpenCV 的向量化实现完成，每帧只处理几千个像素
+class FrameChangeDetector
+{
+public:
+    void configure(const ChangeGateConfig& config);
+
+    // 门控关闭时也计算画面差异，供级联推理判断运动
+    void set_measure(bool measure) { measure_ = measure; }
+
+    // 返回 true 表示画面有变化需要推理，此时当前帧成为新的参考帧
+    bool changed(const cv::Mat& image);
+
+    // 清除参考帧，下一帧必定推理
+    void reset();
+
+    // 返回自上次调用以来的统计并清零
+    ChangeGateStats take_stats();
+
+    // 最近一次比较得到的平均绝对差，没有参考帧时为 0
+    float last_difference() const { return last_difference_; }
+
+private:
+    ChangeGateConfig config_;
+    cv::Mat resized_;
+    cv::Mat sample_;
+    cv::Mat reference_;
+    bool measure_ = false;
+    bool has_reference_ = false;
+    int skipped_in_row_ = 0;
+    float last_difference_ = 0;
+    ChangeGateStats stats_;
+};
+
+#endif //FRAME_CHANGE_DETECTOR_HPP
@@ -0,0 +1,67 @@
+//
+// Created by JellyfishKnight on 25-7-3.
+//
+
+#ifndef FUSED_PREPROCESS_HPP
+#define FUSED_PREPROCESS_HPP
+
+#include <array>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// 单次遍历的预处理：BGR 转灰度、最近邻缩放、归一化并写入 NCHW 输入缓冲区
+// 结果与 cvtColor(BGR2GRAY) -> resize(INTER_NEAREST) -> convertTo(CV_32F, 1/255) 逐位一致
+class FusedPreprocessor
+{
+public:
+    enum class Backend
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    // 使用当前 CPU 支持的最快实现
+    FusedPreprocessor();
+
+    // 指定实现，供测试逐一校验各路径；CPU 不支持时使用最快的可用实现
+    explicit FusedPreprocessor(Backend backend);
+
+    // src 为 CV_8UC1 或 CV_8UC3(BGR)，可以是 ROI；dst 需容纳 dst_w * dst_h 个 float
+    // 输入格式不支持时返回 false，调用者应回退到 OpenCV 流程
+    bool run(const cv::Mat& src, float* dst, int dst_w, int dst_h);
+
+    // 输出 uint8 灰度，归一化由模型完成；结果与 cvtColor(BGR2GRAY) -> resize(INTER_NEAREST) 逐位一致
+    bool run(const cv::Mat& src, uchar* dst, int dst_w, int dst_h);
+
+    // 默认使用的实现：avx2 / sse2 / scalar
+    static const char* backend();
+
+    static const char* backend_name(Backend backend);
+
+    static Backend best_backend();
+
+    static bool supports(Backend backend);
+
+    Backend active_backend() const { return backend_; }
+
+private:
+    // 检查输入格式并按需更新坐标表
+    bool prepare(const cv::Mat& src, const void* dst, int dst_w, int dst_h);
+
+    void update_tables(int src_w, int src_h, int dst_w, int dst_h, int pix_size);
+
+    Backend backend_;
+    std::array<float, 256> lut_{};   // 灰度值到归一化浮点的查找表
+    std::vector<int> x_ofs_;         // 每个输出列对应的源字节偏移
+    std::vector<int> y_ofs_;         // 每个输出行对应的源行号
+    int safe_cols_ = 0;              // 可以按 4 字节读取而不越过行尾的输出列数
+
+    int src_w_ = -1;
+    int src_h_ = -1;
+    int dst_w_ = -1;
+    int dst_h_ = -1;
+    int pix_size_ = -1;
+};
+
+#endif //FUSED_PREPROCESS_HPP
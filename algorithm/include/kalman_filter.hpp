@@ -1,45 +1,390 @@
 //
-// Created by JellyfishKnight on 25-3-3.
+// Created by JellyfishKnight on 25-7-8.
 //
 
 #ifndef KALMAN_FILTER_HPP
 #define KALMAN_FILTER_HPP
 
-#include <functional>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
 
-#include <opencv2/core.hpp>
+// 编译期确定尺寸的行主序矩阵，数据直接存放在对象内
+template <size_t Rows, size_t Cols, typename Scalar>
+struct FixedMatrix
+{
+    static constexpr size_t rows = Rows;
+    static constexpr size_t cols = Cols;
+
+    std::array<Scalar, Rows * Cols> data{};
+
+    constexpr Scalar& operator()(size_t row, size_t col) { return data[row * Cols + col]; }
+
+    constexpr const Scalar& operator()(size_t row, size_t col) const { return data[row * Cols + col]; }
+
+    constexpr void fill(Scalar value) { data.fill(value); }
 
+    constexpr void set_identity(Scalar scale = Scalar(1)) requires (Rows == Cols)
+    {
+        data.fill(Scalar(0));
+        for (size_t i = 0; i < Rows; i++) {
+            (*this)(i, i) = scale;
+        }
+    }
+};
+
+// 状态维度 State、测量维度 Measure、标量类型 Scalar 都在编译期确定，
+// 所有矩阵和中间结果都是成员数组，predict / correct 不分配内存，也不存在矩阵类型不一致的问题。
+// 对象较大（约 3*State^2 + 2*State*Measure 个标量），维度较大时应放在堆上或作为类成员
+template <size_t State, size_t Measure, typename Scalar = double>
 class KalmanFilter
 {
+    static_assert(std::is_floating_point_v<Scalar>, "KalmanFilter 只支持浮点类型");
+    static_assert(State > 0 && Measure > 0);
+
 public:
-    KalmanFilter() = default;
-
-    KalmanFilter(const std::function<cv::Mat(const cv::Mat&)>& TransMat,
-                      const std::function<cv::Mat(const cv::Mat&)>& MeasureMat,
-                      const std::function<cv::Mat()>& update_Q,
-                      const std::function<cv::Mat(const cv::Mat&)>& update_R, const cv::Mat& P);
-
-    void set_state(const cv::Mat& state);
-
-    cv::Mat predict();
-    cv::Mat correct(const cv::Mat& measurement);
-
-    std::function<cv::Mat()> update_Q_;
-    std::function<cv::Mat(const cv::Mat&)> update_R_;
-    std::function<cv::Mat(const cv::Mat&)> trans_mat_;
-    std::function<cv::Mat(const cv::Mat&)> measure_mat_;
-
-    cv::Mat F_;  //状态转移矩阵
-    cv::Mat H_;  //测量转移矩阵
-    cv::Mat Q_;  //过程激励噪声协方差矩阵
-    cv::Mat R_;  //测量噪声协方差矩阵
-    cv::Mat P_pre_;
-    cv::Mat P_post_;
-    cv::Mat gain_;        //卡尔曼增益系数
-    cv::Mat state_pre_;   // k时刻先验估计
-    cv::Mat state_post_;  // k时刻后验估计
+    static constexpr size_t state_size = State;
+    static constexpr size_t measure_size = Measure;
+
+    using StateVector = std::array<Scalar, State>;
+    using MeasureVector = std::array<Scalar, Measure>;
+    using StateMatrix = FixedMatrix<State, State, Scalar>;
+    using MeasureMatrix = FixedMatrix<Measure, State, Scalar>;
+    using NoiseMatrix = FixedMatrix<Measure, Measure, Scalar>;
+
+    KalmanFilter()
+    {
+        F_.set_identity();
+        H_.fill(Scalar(0));
+        for (size_t i = 0; i < Measure && i < State; i++) {
+            H_(i, i) = Scalar(1);
+        }
+        P_.set_identity();
+    }
+
+    // 常速度模型：状态为 [位置, 速度]，F = [I, dt·I; 0, I]，H = [I, 0]
+    // Q 的位置、交叉、速度部分分别为 dt^4/4、dt^3/2、dt^2 乘以 q_factor^2，R = r_factor·I
+    void set_constant_velocity(Scalar dt, Scalar q_factor, Scalar r_factor) requires (State == 2 * Measure)
+    {
+        const Scalar q2 = q_factor * q_factor;
+        const Scalar dt2 = dt * dt;
+        F_.set_identity();
+        H_.fill(Scalar(0));
+        Q_.fill(Scalar(0));
+        for (size_t i = 0; i < Measure; i++) {
+            F_(i, Measure + i) = dt;
+            H_(i, i) = Scalar(1);
+            Q_(i, i) = dt2 * dt2 / Scalar(4) * q2;
+            Q_(i, Measure + i) = dt2 * dt / Scalar(2) * q2;
+            Q_(Measure + i, i) = dt2 * dt / Scalar(2) * q2;
+            Q_(Measure + i, Measure + i) = dt2 * q2;
+        }
+        R_.set_identity(r_factor);
+    }
+
+    // 设置状态，协方差保持不变
+    void set_state(const StateVector& state) { x_ = state; }
+
+    void set_covariance(const StateMatrix& covariance) { P_ = covariance; }
+
+    StateMatrix& transition() { return F_; }
+    MeasureMatrix& measurement() { return H_; }
+    StateMatrix& process_noise() { return Q_; }
+    NoiseMatrix& measurement_noise() { return R_; }
+
+    const StateVector& state() const { return x_; }
+    const StateMatrix& covariance() const { return P_; }
+
+    // x = F x，P = F P F^T + Q
+    const StateVector& predict()
+    {
+        StateVector x{};
+        for (size_t i = 0; i < State; i++) {
+            Scalar sum = 0;
+            for (size_t k = 0; k < State; k++) {
+                sum += F_(i, k) * x_[k];
+            }
+            x[i] = sum;
+        }
+        x_ = x;
+
+        // FP_ = F P
+        for (size_t i = 0; i < State; i++) {
+            for (size_t j = 0; j < State; j++) {
+                FP_(i, j) = 0;
+            }
+            for (size_t k = 0; k < State; k++) {
+                const Scalar f = F_(i, k);
+                if (f == Scalar(0)) {
+                    continue;
+                }
+                for (size_t j = 0; j < State; j++) {
+                    FP_(i, j) += f * P_(k, j);
+                }
+            }
+        }
+        // P = (F P) F^T + Q
+        for (size_t i = 0; i < State; i++) {
+            for (size_t j = 0; j < State; j++) {
+                Scalar sum = Q_(i, j);
+                for (size_t k = 0; k < State; k++) {
+                    sum += FP_(i, k) * F_(j, k);
+                }
+                P_(i, j) = sum;
+            }
+        }
+        return x_;
+    }
+
+    // K = P H^T (H P H^T + R)^-1，x = x + K (z - H x)，P = P - K H P
+    // 新息协方差奇异时不更新并返回 false
+    bool correct(std::span<const Scalar, Measure> measurement)
+    {
+        // HP_ = H P
+        for (size_t i = 0; i < Measure; i++) {
+            for (size_t j = 0; j < State; j++) {
+                HP_(i, j) = 0;
+            }
+            for (size_t k = 0; k < State; k++) {
+                const Scalar h = H_(i, k);
+                if (h == Scalar(0)) {
+                    continue;
+                }
+                for (size_t j = 0; j < State; j++) {
+                    HP_(i, j) += h * P_(k, j);
+                }
+            }
+        }
+        // S_ = H P H^T + R
+        for (size_t i = 0; i < Measure; i++) {
+            for (size_t j = 0; j < Measure; j++) {
+                Scalar sum = R_(i, j);
+                for (size_t k = 0; k < State; k++) {
+                    sum += HP_(i, k) * H_(j, k);
+                }
+                S_(i, j) = sum;
+            }
+        }
+        // P 和 S 对称，K^T = S^-1 (H P)，用高斯-约当消元求解，不显式求逆
+        KT_ = HP_;
+        if (!solve_in_place(S_, KT_)) {
+            return false;
+        }
+
+        MeasureVector innovation{};
+        for (size_t i = 0; i < Measure; i++) {
+            Scalar sum = 0;
+            for (size_t k = 0; k < State; k++) {
+                sum += H_(i, k) * x_[k];
+            }
+            innovation[i] = measurement[i] - sum;
+        }
+        for (size_t i = 0; i < State; i++) {
+            Scalar sum = 0;
+            for (size_t m = 0; m < Measure; m++) {
+                sum += KT_(m, i) * innovation[m];
+            }
+            x_[i] += sum;
+        }
+        // P = P - K (H P)
+        for (size_t m = 0; m < Measure; m++) {
+            for (size_t i = 0; i < State; i++) {
+                const Scalar k = KT_(m, i);
+                if (k == Scalar(0)) {
+                    continue;
+                }
+                for (size_t j = 0; j < State; j++) {
+                    P_(i, j) -= k * HP_(m, j);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool correct(const MeasureVector& measurement)
+    {
+        return correct(std::span<const Scalar, Measure>(measurement));
+    }
+
+private:
+    // 求解 A X = B，结果写回 B，A 被破坏
+    static bool solve_in_place(NoiseMatrix& a, MeasureMatrix& b)
+    {
+        for (size_t col = 0; col < Measure; col++) {
+            size_t pivot = col;
+            for (size_t row = col + 1; row < Measure; row++) {
+                if (std::abs(a(row, col)) > std::abs(a(pivot, col))) {
+                    pivot = row;
+                }
+            }
+            if (a(pivot, col) == Scalar(0)) {
+                return false;
+            }
+            if (pivot != col) {
+                for (size_t j = 0; j < Measure; j++) {
+                    std::swap(a(pivot, j), a(col, j));
+                }
+                for (size_t j = 0; j < State; j++) {
+                    std::swap(b(pivot, j), b(col, j));
+                }
+            }
+            const Scalar inv = Scalar(1) / a(col, col);
+            for (size_t j = col; j < Measure; j++) {
+                a(col, j) *= inv;
+            }
+            for (size_t j = 0; j < State; j++) {
+                b(col, j) *= inv;
+            }
+            for (size_t row = 0; row < Measure; row++) {
+                const Scalar factor = a(row, col);
+                if (row == col || factor == Scalar(0)) {
+                    continue;
+                }
+                for (size_t j = col; j < Measure; j++) {
+                    a(row, j) -= factor * a(col, j);
+                }
+                for (size_t j = 0; j < State; j++) {
+                    b(row, j) -= factor * b(col, j);
+                }
+            }
+        }
+        return true;
+    }
+
+    StateMatrix F_;   // 状态转移矩阵
+    MeasureMatrix H_; // 测量矩阵
+    StateMatrix Q_;   // 过程噪声协方差
+    NoiseMatrix R_;   // 测量噪声协方差
+    StateMatrix P_;   // 误差协方差
+    StateVector x_{}; // 状态
+
+    // 中间结果
+    StateMatrix FP_;
+    MeasureMatrix HP_;
+    MeasureMatrix KT_;
+    NoiseMatrix S_;
 };
 
+// 单通道常速度模型的特化：状态 [位置, 速度]，F = [1, dt; 0, 1]、H = [1, 0] 在编译期固定，不存储矩阵
+// 预测和校正展开为 2x2 闭式计算，测量为标量，不需要求逆。
+// 静态的 predict_step / correct_step 直接作用于单个通道的状态和协方差，
+// KalmanFilterBank 在结构数组上逐通道调用它们，循环内联后仍可被编译器向量化
+template <typename Scalar>
+class KalmanFilter<2, 1, Scalar>
+{
+    static_assert(std::is_floating_point_v<Scalar>, "KalmanFilter 只支持浮点类型");
+
+public:
+    static constexpr size_t state_size = 2;
+    static constexpr size_t measure_size = 1;
+
+    using StateVector = std::array<Scalar, 2>;
+    using MeasureVector = std::array<Scalar, 1>;
+    using StateMatrix = FixedMatrix<2, 2, Scalar>;
+
+    // 由 dt 和 q_factor 算出的过程噪声，所有通道共用，dt 或 q_factor 变化时重新计算
+    struct ProcessNoise
+    {
+        Scalar dt = 0;
+        Scalar q00 = 0; // dt^4/4 * q^2
+        Scalar q01 = 0; // dt^3/2 * q^2
+        Scalar q11 = 0; // dt^2 * q^2
+
+        static constexpr ProcessNoise make(Scalar dt, Scalar q_factor)
+        {
+            const Scalar q2 = q_factor * q_factor;
+            const Scalar dt2 = dt * dt;
+            return ProcessNoise{dt, dt2 * dt2 / Scalar(4) * q2, dt2 * dt / Scalar(2) * q2, dt2 * q2};
+        }
+    };
+
+    // x = F x，P = F P F^T + Q，协方差对称，只保存 [p00, p01; p01, p11]
+    static constexpr void predict_step(Scalar& x, Scalar& v, Scalar& p00, Scalar& p01, Scalar& p11,
+                                       const ProcessNoise& q)
+    {
+        x += q.dt * v;
+        p00 = p00 + q.dt * (Scalar(2) * p01 + q.dt * p11) + q.q00;
+        p01 = p01 + q.dt * p11 + q.q01;
+        p11 = p11 + q.q11;
+    }
 
+    // H = [1, 0]，新息协方差 s = p00 + r 为标量，增益 K = [p00, p01] / s，P = (I - K H) P
+    // 不检查 s 是否为 0，循环中没有分支；r > 0 时 s 总为正
+    static constexpr void correct_step(Scalar& x, Scalar& v, Scalar& p00, Scalar& p01, Scalar& p11,
+                                       Scalar z, Scalar r)
+    {
+        const Scalar s = p00 + r;
+        const Scalar k0 = p00 / s;
+        const Scalar k1 = p01 / s;
+        const Scalar y = z - x;
+        x += k0 * y;
+        v += k1 * y;
+        p11 -= k1 * p01;
+        p01 -= k0 * p01;
+        p00 -= k0 * p00;
+    }
+
+    // 常速度模型，R = r_factor
+    void set_constant_velocity(Scalar dt, Scalar q_factor, Scalar r_factor)
+    {
+        noise_ = ProcessNoise::make(dt, q_factor);
+        r_ = r_factor;
+    }
+
+    // 设置状态，协方差保持不变
+    void set_state(const StateVector& state) { x_ = state; }
+
+    // 只使用上三角，矩阵应对称
+    void set_covariance(const StateMatrix& covariance)
+    {
+        p00_ = covariance(0, 0);
+        p01_ = covariance(0, 1);
+        p11_ = covariance(1, 1);
+    }
+
+    const StateVector& state() const { return x_; }
+
+    StateMatrix covariance() const
+    {
+        StateMatrix covariance;
+        covariance(0, 0) = p00_;
+        covariance(0, 1) = p01_;
+        covariance(1, 0) = p01_;
+        covariance(1, 1) = p11_;
+        return covariance;
+    }
+
+    const StateVector& predict()
+    {
+        predict_step(x_[0], x_[1], p00_, p01_, p11_, noise_);
+        return x_;
+    }
+
+    // 新息协方差为 0 时不更新并返回 false
+    bool correct(std::span<const Scalar, 1> measurement)
+    {
+        if (p00_ + r_ == Scalar(0)) {
+            return false;
+        }
+        correct_step(x_[0], x_[1], p00_, p01_, p11_, measurement[0], r_);
+        return true;
+    }
+
+    bool correct(const MeasureVector& measurement)
+    {
+        return correct(std::span<const Scalar, 1>(measurement));
+    }
+
+private:
+    ProcessNoise noise_;
+    Scalar r_ = 0;
+    StateVector x_{};
+    Scalar p00_ = 1;
+    Scalar p01_ = 0;
+    Scalar p11_ = 1;
+};
 
 #endif //KALMAN_FILTER_HPP
@@ -0,0 +1,54 @@
+//
+// Created by JellyfishKnight on 25-7-7.
+//
+
+#ifndef KALMAN_FILTER_BANK_HPP
+#define KALMAN_FILTER_BANK_HPP
+
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "kalman_filter.hpp"
+
+// 一组相互独立的二维常速度卡尔曼滤波器，每个通道的状态为 [位置, 速度]
+// 等价于状态为 [所有位置, 所有速度] 的稠密滤波器（F = [I, dt·I; 0, I]，H = [I, 0]，Q、R 为对角块），
+// 但各通道按结构数组存储，逐通道调用 KalmanFilter<2, 1> 特化的闭式计算，不需要矩阵乘法、求逆和内存分配
+class KalmanFilterBank
+{
+public:
+    KalmanFilterBank() = default;
+
+    explicit KalmanFilterBank(size_t channels, double initial_covariance = 1.0);
+
+    // 重新设置通道数，状态清零，协方差重置为 initial_covariance * I
+    void resize(size_t channels, double initial_covariance = 1.0);
+
+    using ChannelFilter = KalmanFilter<2, 1, double>;
+
+    size_t size() const { return position_.size(); }
+
+    // 设置状态，协方差保持不变；velocities 为空时速度置零
+    void set_state(std::span<const float> positions, std::span<const float> velocities = {});
+
+    // 预测：x = F x，P = F P F^T + Q
+    // Q 的位置、交叉、速度部分分别为 dt^4/4、dt^3/2、dt^2 乘以 q_factor^2
+    void predict(double dt, double q_factor);
+
+    // 校正：测量噪声 R = r_factor * I
+    void correct(std::span<const float> measurement, double r_factor);
+
+    std::span<const double> positions() const { return position_; }
+
+    std::span<const double> velocities() const { return velocity_; }
+
+private:
+    // 结构数组：每个数组按通道连续存放，循环可被编译器向量化
+    std::vector<double> position_;
+    std::vector<double> velocity_;
+    // 对称的 2x2 协方差 [p00, p01; p01, p11]
+    std::vector<double> p00_;
+    std::vector<double> p01_;
+    std::vector<double> p11_;
+};
+
+#endif //KALMAN_FILTER_BANK_HPP
@@ -0,0 +1,69 @@
+//
+// Created by JellyfishKnight on 25-7-9.
+//
+
+#ifndef LATENCY_PREDICTOR_HPP
+#define LATENCY_PREDICTOR_HPP
+
+#include <limits>
+#include <span>
+#include <vector>
+#include <json.hpp>
+
+// 延迟补偿参数，默认关闭
+// 外推使用输出滤波器估计的速度，需要同时开启输出滤波（use_filter），否则不生效
+struct LatencyPredictionConfig
+{
+    bool enabled = false;
+    // 设备端采集、编码、无线传输以及 OSC 发送等待的估计耗时（毫秒），加在本机测得的延迟上
+    float extra_latency_ms = 20.0f;
+    // 外推时长上限（毫秒）
+    float max_horizon_ms = 80.0f;
+    // 单次外推的最大变化量
+    float max_step = 0.15f;
+    // 速度低于该值（单位/秒）时不外推，避免放大静止时的抖动
+    float min_speed = 0.05f;
+    // 单帧外推误差的平均值达到该值时置信度降为 0，不再外推
+    float error_tolerance = 0.05f;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(LatencyPredictionConfig, enabled, extra_latency_ms, max_horizon_ms,
+                                                max_step, min_speed, error_tolerance);
+};
+
+// 用滤波器估计的速度把输出向前外推一段时间，抵消从采集到发送的延迟
+// 每个通道记录上一帧外推到本帧的误差，误差越大置信度越低，外推量按置信度缩小
+class LatencyPredictor
+{
+public:
+    void configure(const LatencyPredictionConfig& config, size_t channels);
+
+    // 外推结果限制在 [lower, upper] 内
+    void set_range(float lower, float upper);
+
+    // 清除历史，置信度从零开始重新积累
+    void reset();
+
+    // values 为滤波后的值，velocities 为对应速度（单位/秒），dt 为距上一帧的秒数，
+    // horizon 为外推秒数，结果原地写回 values
+    void apply(std::span<float> values, std::span<const float> velocities, double dt, double horizon);
+
+    // 外推时长：本机测得的延迟加上设备端的估计延迟，不超过上限
+    double horizon(double measured_latency) const;
+
+    bool enabled() const { return config_.enabled; }
+
+    std::span<const float> confidence() const { return confidence_; }
+
+private:
+    LatencyPredictionConfig config_;
+    float lower_ = -std::numeric_limits<float>::infinity();
+    float upper_ = std::numeric_limits<float>::infinity();
+    bool initialized_ = false;
+    // 上一帧的值和速度，用于评估外推误差
+    std::vector<float> last_value_;
+    std::vector<float> last_velocity_;
+    std::vector<float> error_;
+    std::vector<float> confidence_;
+};
+
+#endif //LATENCY_PREDICTOR_HPP
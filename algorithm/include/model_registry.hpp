@@ -0,0 +1,100 @@
+//
+// Created by JellyfishKnight on 25-7-2.
+//
+
+#ifndef MODEL_REGISTRY_HPP
+#define MODEL_REGISTRY_HPP
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <onnxruntime_cxx_api.h>
+#include <session_tuner.hpp>
+
+// 单个模型会话的内存占用信息
+struct ModelMemoryInfo
+{
+    std::string model_key;
+    size_t model_bytes = 0;      // 模型文件大小
+    size_t resident_bytes = 0;   // 创建会话前后进程常驻内存的增量
+    long use_count = 0;          // 当前持有该会话的推理实例数量
+};
+
+// 会话请求参数
+struct SessionRequest
+{
+    std::string model_path;      // 外部模型文件，以只读内存映射方式加载
+    std::string fallback_path;   // 外部文件不存在或无法映射时使用的内嵌资源
+    std::string options_tag;     // 区分同一模型的不同会话配置
+    bool use_cache = true;       // 把优化后的图保存为 ORT 格式缓存，之后的启动直接加载缓存
+    bool auto_tune = true;       // 使用本机测试得到的会话参数
+    bool uint8_input = false;    // 在图中插入归一化，输入改为 uint8；模型无法改写时使用原模型
+    SessionTuning default_tuning;   // 未测试或不自动调优时的会话参数
+    int batch_size = 1;          // 推理时的批次大小，自动调优时动态批次维度按该值测试
+};
+
+// 进程内唯一的模型/会话注册表
+// 所有推理实例共用一个 Ort::Env，同一模型、同一会话配置只创建一次会话，
+// 不同配置的会话通过预打包权重容器共享权重内存；
+// 默认所有会话在 Env 的全局线程池上运行，不再各自创建线程池
+class ModelRegistry
+{
+public:
+    static ModelRegistry& instance();
+
+    ModelRegistry(const ModelRegistry&) = delete;
+    ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+    // 设置全局线程池大小，必须在第一次调用 instance() 之前设置
+    // -1 按核心数减去流水线线程数自动计算，0 关闭全局线程池，各会话使用自己的线程池
+    static void set_global_pool_threads(int threads);
+
+    Ort::Env& env();
+
+    // 全局线程池的线程数，0 表示未使用全局线程池
+    int global_pool_threads() const;
+
+    // 获取共享会话，同一模型内容、同一 options_tag 只创建一次
+    // 会话创建失败时抛出 Ort::Exception，由调用者决定如何回退
+    std::shared_ptr<Ort::Session> acquire_session(const SessionRequest& request,
+                                                  const Ort::SessionOptions& options);
+
+    // 释放已没有推理实例持有的会话
+    void release_unused();
+
+    // 各模型会话的内存占用
+    std::vector<ModelMemoryInfo> memory_report();
+
+    void log_memory_report();
+
+private:
+    ModelRegistry();
+
+    // 查找已创建的会话，没有时返回 nullptr
+    std::shared_ptr<Ort::Session> find_session(const std::string& key);
+
+    // 通过优化模型缓存创建会话，缓存不可用时返回 nullptr
+    std::shared_ptr<Ort::Session> create_cached_session(const std::string& model_path,
+                                                        const std::string& session_tag,
+                                                        const std::string& model_hash,
+                                                        const void* model_data,
+                                                        size_t model_size,
+                                                        const Ort::SessionOptions& options);
+
+    struct Entry
+    {
+        std::shared_ptr<Ort::Session> session;
+        size_t model_bytes = 0;
+        size_t resident_bytes = 0;
+    };
+
+    std::mutex mutex_;
+    int global_pool_threads_ = 0;
+    std::unique_ptr<Ort::Env> env_;
+    Ort::PrepackedWeightsContainer prepacked_weights_;
+    std::unordered_map<std::string, Entry> sessions_;
+};
+
+#endif //MODEL_REGISTRY_HPP
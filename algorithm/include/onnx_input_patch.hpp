@@ -0,0 +1,17 @@
+//
+// Created by JellyfishKnight on 25-7-11.
+//
+
+#ifndef ONNX_INPUT_PATCH_HPP
+#define ONNX_INPUT_PATCH_HPP
+
+#include <cstddef>
+#include <string>
+
+// 把模型的第一个 float 输入改为 uint8：原输入改名为 <name>_uint8，
+// 在图的最前面插入 Cast(to=float) 和 Mul(1/255)，输出沿用原输入名，其余节点不变
+// 归一化在图内完成，与预处理中的 1/255 查找表逐位一致
+// 只改写 protobuf 中涉及的字段，不依赖 onnx 库；模型格式不支持或输入不是 float 时返回 false，out 不变
+bool patch_uint8_input(const void* model_data, size_t model_size, std::string& out);
+
+#endif //ONNX_INPUT_PATCH_HPP
@@ -0,0 +1,146 @@
+//
+// Created by JellyfishKnight on 25-7-8.
+//
+
+#ifndef OUTPUT_FILTER_HPP
+#define OUTPUT_FILTER_HPP
+
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <json.hpp>
+#include "kalman_filter_bank.hpp"
+#include "latency_predictor.hpp"
+
+enum class OutputFilterType
+{
+    Kalman,
+    OneEuro,
+    None,
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(OutputFilterType, {
+    {OutputFilterType::Kalman, "kalman"},
+    {OutputFilterType::OneEuro, "one_euro"},
+    {OutputFilterType::None, "none"},
+})
+
+// 一组通道的滤波方式，卡尔曼滤波的 q、r 沿用推理类中的参数
+struct OutputFilterConfig
+{
+    OutputFilterType type = OutputFilterType::Kalman;
+    // 一欧元滤波：静止时的截止频率（Hz），越小越平滑
+    float min_cutoff = 1.0f;
+    // 截止频率随速度增加的系数，越大快速动作时延迟越小
+    float beta = 5.0f;
+    // 速度估计的截止频率（Hz）
+    float d_cutoff = 1.0f;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(OutputFilterConfig, type, min_cutoff, beta, d_cutoff);
+};
+
+// 一个追踪器的滤波设置：默认方式，以及按分组（如 "jaw"、"mouth"、"eyelid"）单独指定的方式
+struct OutputFilterSettings
+{
+    OutputFilterConfig defaults;
+    std::map<std::string, OutputFilterConfig> groups;
+    // 滤波后的延迟补偿
+    LatencyPredictionConfig prediction;
+
+    const OutputFilterConfig& for_group(const std::string& group) const;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(OutputFilterSettings, defaults, groups, prediction);
+};
+
+// 每帧传给滤波器的参数
+struct FilterStep
+{
+    double dt = 0.02;       // 距上一帧的秒数
+    double q_factor = 0.5;  // 卡尔曼过程噪声系数
+    double r_factor = 5e-5; // 卡尔曼测量噪声系数
+};
+
+// 对固定数量的通道逐帧原地滤波
+class OutputFilter
+{
+public:
+    virtual ~OutputFilter() = default;
+
+    // 清除历史，下一帧以测量值作为初始状态
+    virtual void reset() = 0;
+
+    virtual void apply(std::span<float> values, const FilterStep& step) = 0;
+
+    // 写入各通道当前的速度估计（单位/秒），不提供速度时返回 false
+    virtual bool velocities(std::span<float>) const { return false; }
+};
+
+// 逐通道常速度卡尔曼滤波
+class KalmanOutputFilter final : public OutputFilter
+{
+public:
+    explicit KalmanOutputFilter(size_t channels);
+
+    void reset() override;
+
+    void apply(std::span<float> values, const FilterStep& step) override;
+
+    bool velocities(std::span<float> out) const override;
+
+private:
+    KalmanFilterBank bank_;
+    bool initialized_ = false;
+};
+
+// 一欧元滤波：低通截止频率随速度估计自适应，静止时抑制抖动，快速动作（眨眼、张嘴）时几乎不引入延迟
+class OneEuroOutputFilter final : public OutputFilter
+{
+public:
+    OneEuroOutputFilter(size_t channels, const OutputFilterConfig& config);
+
+    void reset() override;
+
+    void apply(std::span<float> values, const FilterStep& step) override;
+
+    bool velocities(std::span<float> out) const override;
+
+private:
+    OutputFilterConfig config_;
+    std::vector<float> value_;
+    std::vector<float> derivative_;
+    bool initialized_ = false;
+};
+
+std::unique_ptr<OutputFilter> make_output_filter(const OutputFilterConfig& config, size_t channels);
+
+// 按分组把通道分配给各自的滤波器，配置后每帧滤波不分配内存
+class GroupedOutputFilter
+{
+public:
+    // channel_groups[i] 为第 i 个通道所属的分组，设置为 None 的分组不滤波
+    void configure(std::span<const std::string> channel_groups, const OutputFilterSettings& settings);
+
+    void reset();
+
+    void apply(std::span<float> values, const FilterStep& step);
+
+    // 写入各通道的速度估计，不滤波或滤波器不提供速度的通道为 0
+    void velocities(std::span<float> out);
+
+private:
+    struct Group
+    {
+        std::vector<size_t> channels;
+        std::vector<float> values;
+        std::unique_ptr<OutputFilter> filter;
+    };
+
+    std::vector<Group> groups_;
+};
+
+// ARKit 名称的分组为首个大写字母之前的部分，如 "jawOpen" -> "jaw"
+std::string blendshape_group(const std::string& name);
+
+#endif //OUTPUT_FILTER_HPP
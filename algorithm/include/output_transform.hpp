@@ -0,0 +1,33 @@
+//
+// Created by JellyfishKnight on 25-7-9.
+//
+
+#ifndef OUTPUT_TRANSFORM_HPP
+#define OUTPUT_TRANSFORM_HPP
+
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 由偏置和增益设置编译出的逐通道变换：y = min(clamp(x + offset, lower, upper) * gain, limit)
+// 设置变化时重新编译，每帧只按下标遍历一次数组，不查找字符串
+struct OutputTransform
+{
+    std::vector<float> offset;
+    std::vector<float> lower;
+    std::vector<float> upper;
+    std::vector<float> gain;
+    std::vector<float> limit;
+
+    // names 为各通道的名称，未出现在映射表中的通道保持原值
+    static OutputTransform compile(const std::vector<std::string>& names,
+                                   const std::unordered_map<std::string, float>& offset_map,
+                                   const std::unordered_map<std::string, int>& amp_map);
+
+    void apply(std::span<float> values) const;
+
+    size_t size() const { return offset.size(); }
+};
+
+#endif //OUTPUT_TRANSFORM_HPP
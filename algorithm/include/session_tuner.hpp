@@ -0,0 +1,101 @@
+//
+// Created by JellyfishKnight on 25-7-5.
+//
+
+#ifndef SESSION_TUNER_HPP
+#define SESSION_TUNER_HPP
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <config_writer.hpp>
+#include <onnxruntime_cxx_api.h>
+
+// 一组 ORT 会话执行参数
+struct SessionTuning
+{
+    // 0 表示不创建会话线程池，使用 Env 的全局线程池
+    int intra_op_threads = 1;
+    bool allow_spinning = false;
+    bool mem_pattern = false;
+    bool parallel_execution = false;
+
+    void apply(Ort::SessionOptions& options) const;
+
+    // 用于区分会话和缓存文件的短标签
+    std::string tag() const;
+
+    // 解析 "threads=2,spinning=0,mem_pattern=0,parallel=0"，未出现的字段保持原值
+    static bool parse(const std::string& text, SessionTuning& tuning);
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(SessionTuning, intra_op_threads, allow_spinning, mem_pattern, parallel_execution);
+};
+
+// 单个模型在本机的测试结果
+struct SessionTuningRecord
+{
+    std::string model_hash;
+    SessionTuning tuning;
+    double median_ms = 0;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(SessionTuningRecord, model_hash, tuning, median_ms);
+};
+
+// session_tuning.json 的内容
+struct SessionTuningFile
+{
+    std::string machine_id;
+    // 为 true 时所有会话固定使用 pinned_tuning，不再自动测试
+    bool pinned = false;
+    SessionTuning pinned_tuning;
+    std::map<std::string, SessionTuningRecord> models;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(SessionTuningFile, machine_id, pinned, pinned_tuning, models);
+};
+
+// 启动时为每个模型测试候选会话参数，并按机器保存最优结果
+class SessionTuner
+{
+public:
+    using Benchmark = std::function<double(const SessionTuning&)>;
+
+    static SessionTuner& instance();
+
+    // 命令行指定的固定参数，优先级最高
+    void set_override(const SessionTuning& tuning);
+
+    // 忽略已保存的结果，本次启动重新测试
+    void request_retune();
+
+    // 命令行覆盖或配置文件固定的参数，没有时为空；这些参数不经测试直接使用
+    std::optional<SessionTuning> explicit_tuning();
+
+    // 获取模型的会话参数：命令行覆盖 > 配置文件固定参数 > 本机已保存结果 > 现场测试
+    // 现场测试时持有调优器自身的锁，多个模型依次测试，互不干扰计时；调用者不应持有其它锁
+    SessionTuning tuning_for(const std::string& model_key, const std::string& model_hash,
+                             const SessionTuning& defaults, const Benchmark& benchmark);
+
+    // 用全零输入测试一组参数，返回单次推理耗时的中位数（毫秒），失败时抛出异常
+    // 动态的第 0 维按 batch_size 测试，其余动态维度按 1
+    static double benchmark(Ort::Env& env, const void* model_data, size_t model_size,
+                            const Ort::SessionOptions& base_options, const SessionTuning& tuning,
+                            int batch_size = 1);
+
+    // 主机名、CPU 架构和线程数，换机器后已保存的结果和优化模型缓存都不再适用
+    static std::string current_machine_id();
+
+private:
+    SessionTuner();
+
+    std::mutex mutex_;
+    ConfigWriter writer_;
+    std::string machine_id_;
+    std::optional<SessionTuning> override_;
+    bool retune_ = false;
+    std::set<std::string> retuned_;
+};
+
+#endif //SESSION_TUNER_HPP
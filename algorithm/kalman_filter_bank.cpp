@@ -0,0 +1,57 @@
+//
+// Created by JellyfishKnight on 25-7-7.
+//
+#include "kalman_filter_bank.hpp"
+#include <algorithm>
+
+KalmanFilterBank::KalmanFilterBank(size_t channels, double initial_covariance)
+{
+    resize(channels, initial_covariance);
+}
+
+void KalmanFilterBank::resize(size_t channels, double initial_covariance)
+{
+    position_.assign(channels, 0.0);
+    velocity_.assign(channels, 0.0);
+    p00_.assign(channels, initial_covariance);
+    p01_.assign(channels, 0.0);
+    p11_.assign(channels, initial_covariance);
+}
+
+void KalmanFilterBank::set_state(std::span<const float> positions, std::span<const float> velocities)
+{
+    const size_t n = size();
+    for (size_t i = 0; i < n; i++) {
+        position_[i] = i < positions.size() ? positions[i] : 0.0;
+        velocity_[i] = i < velocities.size() ? velocities[i] : 0.0;
+    }
+}
+
+void KalmanFilterBank::predict(double dt, double q_factor)
+{
+    // 过程噪声每次调用只计算一次，所有通道共用
+    const auto noise = ChannelFilter::ProcessNoise::make(dt, q_factor);
+    const size_t n = size();
+    double* x = position_.data();
+    double* v = velocity_.data();
+    double* p00 = p00_.data();
+    double* p01 = p01_.data();
+    double* p11 = p11_.data();
+    for (size_t i = 0; i < n; i++) {
+        ChannelFilter::predict_step(x[i], v[i], p00[i], p01[i], p11[i], noise);
+    }
+}
+
+void KalmanFilterBank::correct(std::span<const float> measurement, double r_factor)
+{
+    const size_t n = std::min(size(), measurement.size());
+    double* x = position_.data();
+    double* v = velocity_.data();
+    double* p00 = p00_.data();
+    double* p01 = p01_.data();
+    double* p11 = p11_.data();
+    const float* z = measurement.data();
+    for (size_t i = 0; i < n; i++) {
+        ChannelFilter::correct_step(x[i], v[i], p00[i], p01[i], p11[i], static_cast<double>(z[i]), r_factor);
+    }
+}
@@ -0,0 +1,67 @@
+//
+// Created by JellyfishKnight on 25-7-9.
+//
+#include "latency_predictor.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // 外推误差的指数平均系数
+    constexpr float kErrorSmoothing = 0.1f;
+}
+
+void LatencyPredictor::configure(const LatencyPredictionConfig& config, size_t channels)
+{
+    config_ = config;
+    last_value_.assign(channels, 0.0f);
+    last_velocity_.assign(channels, 0.0f);
+    error_.assign(channels, 0.0f);
+    confidence_.assign(channels, 0.0f);
+    initialized_ = false;
+}
+
+void LatencyPredictor::set_range(float lower, float upper)
+{
+    lower_ = lower;
+    upper_ = upper;
+}
+
+void LatencyPredictor::reset()
+{
+    std::fill(error_.begin(), error_.end(), 0.0f);
+    std::fill(confidence_.begin(), confidence_.end(), 0.0f);
+    initialized_ = false;
+}
+
+double LatencyPredictor::horizon(double measured_latency) const
+{
+    double latency = std::max(0.0, measured_latency) + config_.extra_latency_ms / 1000.0;
+    return std::min(latency, config_.max_horizon_ms / 1000.0);
+}
+
+void LatencyPredictor::apply(std::span<float> values, std::span<const float> velocities, double dt, double horizon)
+{
+    const size_t n = std::min({values.size(), velocities.size(), last_value_.size()});
+    const float tolerance = std::max(config_.error_tolerance, 1e-6f);
+    for (size_t i = 0; i < n; i++) {
+        const float value = values[i];
+        const float velocity = velocities[i];
+        if (initialized_) {
+            // 用上一帧的速度外推到本帧，误差反映该通道速度估计是否可信
+            float predicted = last_value_[i] + last_velocity_[i] * static_cast<float>(dt);
+            error_[i] += kErrorSmoothing * (std::abs(value - predicted) - error_[i]);
+            confidence_[i] = std::clamp(1.0f - error_[i] / tolerance, 0.0f, 1.0f);
+        }
+        last_value_[i] = value;
+        last_velocity_[i] = velocity;
+
+        if (std::abs(velocity) < config_.min_speed) {
+            continue;
+        }
+        float step = velocity * static_cast<float>(horizon) * confidence_[i];
+        step = std::clamp(step, -config_.max_step, config_.max_step);
+        values[i] = std::clamp(value + step, lower_, upper_);
+    }
+    initialized_ = true;
+}
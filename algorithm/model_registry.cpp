@@ -0,0 +1,399 @@
+//
+// Created by JellyfishKnight on 25-7-2.
+//
+#include "model_registry.hpp"
+#include <logger.hpp>
+#include <mapped_file.hpp>
+#include <onnx_input_patch.hpp>
+#include <QByteArray>
+#include <QResource>
+#include <QString>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fstream>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // 优化模型缓存目录
+    constexpr const char* kModelCacheDir = "./model_cache";
+
+    // 占用 CPU 的流水线线程：UI 主线程、面部推理、眼部推理、图像接收解码
+    constexpr int kPipelineThreads = 4;
+
+    std::atomic<int> requested_pool_threads{-1};
+
+    // FNV-1a 64 位哈希，用于识别模型内容
+    uint64_t fnv1a_hash(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // 缓存文件名包含模型名、模型哈希、ORT 版本、本机标识和会话配置
+    // ORT_ENABLE_ALL 会按本机 CPU 指令集改写布局，缓存目录拷到其它机器后不能复用
+    std::string cache_file_name(const std::string& model_path, const std::string& session_tag, const std::string& model_hash)
+    {
+        static const std::string machine_hash = [] {
+            std::string machine_id = SessionTuner::current_machine_id();
+            return std::format("{:08x}", static_cast<uint32_t>(fnv1a_hash(machine_id.data(), machine_id.size())));
+        }();
+        std::string stem = std::filesystem::path(model_path).stem().string();
+        return std::format("{}_{}_ort{}_{}_{}.ort", stem, model_hash, Ort::GetVersionString(), machine_hash, session_tag);
+    }
+
+    bool is_resource_path(const std::string& path)
+    {
+        return path.starts_with(":/");
+    }
+
+    // 模型字节：外部文件为只读映射，内嵌资源未压缩时直接指向可执行文件中的数据
+    struct ModelBytes
+    {
+        MappedFile mapped;
+        QByteArray uncompressed;
+        std::string patched;     // 改写输入后的模型
+        const void* data = nullptr;
+        size_t size = 0;
+    };
+
+    bool open_model_bytes(const std::string& path, ModelBytes& bytes)
+    {
+        if (!is_resource_path(path)) {
+            if (!bytes.mapped.open(path)) {
+                return false;
+            }
+            bytes.data = bytes.mapped.data();
+            bytes.size = bytes.mapped.size();
+            return true;
+        }
+        QResource resource(QString::fromStdString(path));
+        if (!resource.isValid()) {
+            return false;
+        }
+        if (resource.compressionAlgorithm() == QResource::NoCompress) {
+            bytes.data = resource.data();
+            bytes.size = static_cast<size_t>(resource.size());
+        } else {
+            // 压缩的资源只能解压出一份拷贝
+            bytes.uncompressed = resource.uncompressedData();
+            bytes.data = bytes.uncompressed.constData();
+            bytes.size = static_cast<size_t>(bytes.uncompressed.size());
+        }
+        return bytes.size > 0;
+    }
+
+    // 当前进程常驻内存大小（字节）
+    size_t current_resident_bytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.WorkingSetSize;
+        }
+        return 0;
+#else
+        std::ifstream statm("/proc/self/statm");
+        size_t total_pages = 0, resident_pages = 0;
+        if (statm >> total_pages >> resident_pages) {
+            return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        }
+        return 0;
+#endif
+    }
+
+    double to_mb(size_t bytes)
+    {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+}
+
+ModelRegistry& ModelRegistry::instance()
+{
+    static ModelRegistry registry;
+    return registry;
+}
+
+void ModelRegistry::set_global_pool_threads(int threads)
+{
+    requested_pool_threads = threads;
+}
+
+ModelRegistry::ModelRegistry()
+{
+    int threads = requested_pool_threads;
+    if (threads < 0) {
+        // 调用 Run 的推理线程本身也参与计算，线程池只补足剩余的核心
+        int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        threads = std::max(1, cores - kPipelineThreads);
+    }
+    if (threads == 0) {
+        env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "PaperTracker");
+        LOG_INFO("未使用 ORT 全局线程池，各会话使用自己的线程池");
+        return;
+    }
+    try {
+        Ort::ThreadingOptions threading_options;
+        threading_options.SetGlobalIntraOpNumThreads(threads);
+        threading_options.SetGlobalInterOpNumThreads(1);
+        threading_options.SetGlobalSpinControl(0);
+        env_ = std::make_unique<Ort::Env>(threading_options, ORT_LOGGING_LEVEL_WARNING, "PaperTracker");
+        global_pool_threads_ = threads;
+        LOG_INFO("ORT 全局线程池: {} 个线程", threads);
+    } catch (const Ort::Exception& e) {
+        LOG_WARN("无法创建 ORT 全局线程池: {}，各会话使用自己的线程池", e.what());
+        env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "PaperTracker");
+    }
+}
+
+Ort::Env& ModelRegistry::env()
+{
+    return *env_;
+}
+
+int ModelRegistry::global_pool_threads() const
+{
+    return global_pool_threads_;
+}
+
+std::shared_ptr<Ort::Session> ModelRegistry::acquire_session(const SessionRequest& request,
+                                                             const Ort::SessionOptions& options)
+{
+    // 读取模型和计算哈希不涉及注册表状态，不需要加锁
+    const std::string& model_path = request.model_path;
+    const std::string& fallback_path = request.fallback_path;
+
+    // 外部模型文件不存在时使用内嵌资源
+    std::string source_path = model_path;
+    std::error_code ec;
+    if (!is_resource_path(model_path) && !fallback_path.empty() &&
+        !std::filesystem::exists(std::u8string(model_path.begin(), model_path.end()), ec)) {
+        LOG_WARN("模型文件 {} 不存在，使用内嵌模型", model_path);
+        source_path = fallback_path;
+    }
+
+    ModelBytes bytes;
+    if (!open_model_bytes(source_path, bytes)) {
+        if (source_path == fallback_path || fallback_path.empty() || !open_model_bytes(fallback_path, bytes)) {
+            throw std::runtime_error("无法打开模型文件: " + source_path);
+        }
+        LOG_WARN("无法映射模型文件 {}，使用内嵌模型", source_path);
+        source_path = fallback_path;
+    }
+
+    if (request.uint8_input) {
+        // 改写后的模型哈希不同，缓存、调优结果和会话都与 float 输入的模型分开
+        if (patch_uint8_input(bytes.data, bytes.size, bytes.patched)) {
+            bytes.data = bytes.patched.data();
+            bytes.size = bytes.patched.size();
+            LOG_INFO("模型 {} 已改为 uint8 输入", source_path);
+        } else {
+            LOG_WARN("模型 {} 无法改为 uint8 输入，使用原模型输入", source_path);
+        }
+    }
+
+    // 键中包含模型哈希，同一路径下替换了模型文件时会创建新会话
+    const std::string model_hash = std::format("{:016x}", fnv1a_hash(bytes.data, bytes.size));
+    const std::string key = source_path + "|" + request.options_tag + "|" + model_hash;
+    if (auto session = find_session(key)) {
+        return session;
+    }
+
+    // 按本机测试结果设置线程和执行参数，使用全局线程池时线程数固定为 0（不创建会话线程池）
+    bool shared_pool = global_pool_threads_ > 0;
+    if (shared_pool && request.auto_tune) {
+        // 命令行或配置文件明确指定了线程数时按指定值执行，该会话改用自己的线程池
+        auto fixed = SessionTuner::instance().explicit_tuning();
+        if (fixed && fixed->intra_op_threads > 0) {
+            LOG_WARN("会话参数指定了 {} 个线程，{} 不使用全局线程池（{} 个线程），改用自己的会话线程池",
+                     fixed->intra_op_threads, request.options_tag, global_pool_threads_);
+            shared_pool = false;
+        }
+    }
+    SessionTuning defaults = request.default_tuning;
+    if (shared_pool) {
+        defaults.intra_op_threads = 0;
+    }
+    SessionTuning tuning = defaults;
+    if (request.auto_tune) {
+        // 测试可能持续数秒，在注册表锁外进行，其它模型的会话获取和内存统计不受影响
+        // 批次大小不同时最优参数不同，分开保存
+        std::string tune_key = shared_pool ? request.options_tag + "@global_pool" : request.options_tag;
+        if (request.batch_size > 1) {
+            tune_key += std::format("@batch{}", request.batch_size);
+        }
+        tuning = SessionTuner::instance().tuning_for(tune_key, model_hash, defaults,
+            [&](const SessionTuning& candidate) {
+                return SessionTuner::benchmark(*env_, bytes.data, bytes.size, options, candidate, request.batch_size);
+            });
+    }
+    // 全局线程池和会话线程池不能混用
+    if (shared_pool) {
+        tuning.intra_op_threads = 0;
+    } else if (tuning.intra_op_threads <= 0) {
+        tuning.intra_op_threads = std::max(1, request.default_tuning.intra_op_threads);
+    }
+    Ort::SessionOptions session_options = options.Clone();
+    tuning.apply(session_options);
+    const std::string session_tag = request.options_tag + "_" + tuning.tag();
+
+    // 在锁内创建会话，内存增量只包含当前模型
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 测试期间其它线程可能已创建了同一会话
+    auto it = sessions_.find(key);
+    if (it != sessions_.end() && it->second.session) {
+        LOG_DEBUG("复用已加载的模型会话: {}", key);
+        return it->second.session;
+    }
+    size_t resident_before = current_resident_bytes();
+    std::shared_ptr<Ort::Session> session;
+    if (request.use_cache) {
+        session = create_cached_session(source_path, session_tag, model_hash, bytes.data, bytes.size, session_options);
+    }
+    if (!session) {
+        session = std::make_shared<Ort::Session>(*env_, bytes.data, bytes.size, session_options, prepacked_weights_);
+    }
+    size_t resident_after = current_resident_bytes();
+
+    Entry entry;
+    entry.session = session;
+    entry.model_bytes = bytes.size;
+    entry.resident_bytes = resident_after > resident_before ? resident_after - resident_before : 0;
+    sessions_[key] = std::move(entry);
+
+    LOG_INFO("模型会话已创建: {}（{}），模型 {:.1f} MB，常驻内存增加 {:.1f} MB",
+             key, tuning.tag(), to_mb(sessions_[key].model_bytes), to_mb(sessions_[key].resident_bytes));
+    return session;
+}
+
+std::shared_ptr<Ort::Session> ModelRegistry::find_session(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(key);
+    if (it != sessions_.end() && it->second.session) {
+        LOG_DEBUG("复用已加载的模型会话: {}", key);
+        return it->second.session;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Ort::Session> ModelRegistry::create_cached_session(const std::string& model_path,
+                                                                   const std::string& session_tag,
+                                                                   const std::string& model_hash,
+                                                                   const void* model_data,
+                                                                   size_t model_size,
+                                                                   const Ort::SessionOptions& options)
+{
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(kModelCacheDir, ec);
+    if (ec) {
+        LOG_WARN("无法创建模型缓存目录 {}: {}", kModelCacheDir, ec.message());
+        return nullptr;
+    }
+    fs::path cache_path = fs::path(kModelCacheDir) / cache_file_name(model_path, session_tag, model_hash);
+
+    if (fs::exists(cache_path, ec)) {
+        MappedFile cache_file;
+        if (cache_file.open(cache_path.string())) {
+            try {
+                // 缓存中的图已经优化过，加载时跳过图优化
+                Ort::SessionOptions cache_options = options.Clone();
+                cache_options.AddConfigEntry("session.load_model_format", "ORT");
+                cache_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+                auto session = std::make_shared<Ort::Session>(
+                    *env_, cache_file.data(), cache_file.size(), cache_options, prepacked_weights_);
+                LOG_INFO("使用优化模型缓存: {}", cache_path.string());
+                return session;
+            } catch (const Ort::Exception& e) {
+                LOG_WARN("优化模型缓存不可用，重新生成: {}", e.what());
+            }
+        }
+        cache_file.close();
+        fs::remove(cache_path, ec);
+    }
+
+    // 首次加载时保存优化后的图，写入临时文件后再改名，避免留下不完整的缓存
+    fs::path temp_path = cache_path;
+    temp_path += ".tmp";
+    try {
+        Ort::SessionOptions save_options = options.Clone();
+        save_options.SetOptimizedModelFilePath(temp_path.c_str());
+        save_options.AddConfigEntry("session.save_model_format", "ORT");
+        auto session = std::make_shared<Ort::Session>(*env_, model_data, model_size, save_options, prepacked_weights_);
+        fs::rename(temp_path, cache_path, ec);
+        if (ec) {
+            LOG_WARN("无法写入优化模型缓存 {}: {}", cache_path.string(), ec.message());
+            fs::remove(temp_path, ec);
+        } else {
+            LOG_INFO("优化模型已缓存: {}", cache_path.string());
+        }
+        return session;
+    } catch (const Ort::Exception& e) {
+        LOG_WARN("无法生成优化模型缓存: {}", e.what());
+        fs::remove(temp_path, ec);
+        return nullptr;
+    }
+}
+
+void ModelRegistry::release_unused()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        // 只剩注册表自身持有时释放
+        if (it->second.session.use_count() <= 1) {
+            LOG_INFO("释放模型会话: {}", it->first);
+            it = sessions_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<ModelMemoryInfo> ModelRegistry::memory_report()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ModelMemoryInfo> report;
+    report.reserve(sessions_.size());
+    for (const auto& [key, entry] : sessions_) {
+        ModelMemoryInfo info;
+        info.model_key = key;
+        info.model_bytes = entry.model_bytes;
+        info.resident_bytes = entry.resident_bytes;
+        // 注册表自身持有一份引用，不计入使用者
+        info.use_count = entry.session ? entry.session.use_count() - 1 : 0;
+        report.push_back(std::move(info));
+    }
+    return report;
+}
+
+void ModelRegistry::log_memory_report()
+{
+    auto report = memory_report();
+    size_t total = 0;
+    for (const auto& info : report) {
+        LOG_INFO("模型 {}: 模型 {:.1f} MB，常驻内存 {:.1f} MB，使用者 {}",
+                 info.model_key, to_mb(info.model_bytes), to_mb(info.resident_bytes), info.use_count);
+        total += info.resident_bytes;
+    }
+    LOG_INFO("模型会话共 {} 个，常驻内存合计 {:.1f} MB，进程常驻内存 {:.1f} MB",
+             report.size(), to_mb(total), to_mb(current_resident_bytes()));
+}
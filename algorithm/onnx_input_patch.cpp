@@ -0,0 +1,394 @@
+//
+// Created by JellyfishKnight on 25-7-11.
+//
+#include "onnx_input_patch.hpp"
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    // onnx.proto 中用到的字段编号
+    constexpr uint32_t kModelGraph = 7;
+    constexpr uint32_t kModelOpsetImport = 8;
+    constexpr uint32_t kOpsetDomain = 1;
+    constexpr uint32_t kOpsetVersion = 2;
+    constexpr uint32_t kGraphNode = 1;
+    constexpr uint32_t kGraphInitializer = 5;
+    constexpr uint32_t kGraphInput = 11;
+    constexpr uint32_t kNodeInput = 1;
+    constexpr uint32_t kNodeOutput = 2;
+    constexpr uint32_t kNodeName = 3;
+    constexpr uint32_t kNodeOpType = 4;
+    constexpr uint32_t kNodeAttribute = 5;
+    constexpr uint32_t kAttributeName = 1;
+    constexpr uint32_t kAttributeInt = 3;
+    constexpr uint32_t kAttributeType = 20;
+    constexpr uint32_t kTensorDataType = 2;
+    constexpr uint32_t kTensorFloatData = 4;
+    constexpr uint32_t kTensorName = 8;
+    constexpr uint32_t kValueInfoName = 1;
+    constexpr uint32_t kValueInfoType = 2;
+    constexpr uint32_t kTypeTensor = 1;
+    constexpr uint32_t kTensorTypeElemType = 1;
+
+    constexpr uint64_t kElemFloat = 1;
+    constexpr uint64_t kElemUint8 = 2;
+    constexpr uint64_t kAttributeTypeInt = 2;
+    // Mul 的多向广播从 opset 7 开始支持
+    constexpr uint64_t kMinOpset = 7;
+
+    constexpr uint32_t kWireVarint = 0;
+    constexpr uint32_t kWireFixed64 = 1;
+    constexpr uint32_t kWireBytes = 2;
+    constexpr uint32_t kWireFixed32 = 5;
+
+    struct Field
+    {
+        uint32_t number = 0;
+        uint32_t wire_type = 0;
+        uint64_t varint = 0;        // wire_type 为 varint 时的值
+        std::string_view payload;   // wire_type 为 bytes 时的内容
+        std::string_view raw;       // 包含 tag 的完整字段，原样写回时使用
+    };
+
+    bool read_varint(std::string_view& in, uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+            auto byte = static_cast<uint8_t>(in.front());
+            in.remove_prefix(1);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 读取下一个字段，格式错误或遇到已废弃的 group 时返回 false
+    bool next_field(std::string_view& in, Field& field)
+    {
+        const char* start = in.data();
+        uint64_t tag = 0;
+        if (!read_varint(in, tag)) {
+            return false;
+        }
+        field.number = static_cast<uint32_t>(tag >> 3);
+        field.wire_type = static_cast<uint32_t>(tag & 7);
+        field.varint = 0;
+        field.payload = {};
+        switch (field.wire_type) {
+        case kWireVarint:
+            if (!read_varint(in, field.varint)) {
+                return false;
+            }
+            break;
+        case kWireFixed64:
+        case kWireFixed32: {
+            size_t size = field.wire_type == kWireFixed64 ? 8 : 4;
+            if (in.size() < size) {
+                return false;
+            }
+            in.remove_prefix(size);
+            break;
+        }
+        case kWireBytes: {
+            uint64_t size = 0;
+            if (!read_varint(in, size) || size > in.size()) {
+                return false;
+            }
+            field.payload = in.substr(0, size);
+            in.remove_prefix(size);
+            break;
+        }
+        default:
+            return false;
+        }
+        field.raw = std::string_view(start, in.data() - start);
+        return field.number != 0;
+    }
+
+    void write_varint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void write_varint_field(std::string& out, uint32_t number, uint64_t value)
+    {
+        write_varint(out, (static_cast<uint64_t>(number) << 3) | kWireVarint);
+        write_varint(out, value);
+    }
+
+    void write_bytes_field(std::string& out, uint32_t number, std::string_view payload)
+    {
+        write_varint(out, (static_cast<uint64_t>(number) << 3) | kWireBytes);
+        write_varint(out, payload.size());
+        out.append(payload);
+    }
+
+    // 在 message 中查找第一个指定编号的 bytes 字段
+    bool find_bytes(std::string_view message, uint32_t number, std::string_view& payload)
+    {
+        Field field;
+        while (!message.empty()) {
+            if (!next_field(message, field)) {
+                return false;
+            }
+            if (field.number == number && field.wire_type == kWireBytes) {
+                payload = field.payload;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 把 TypeProto.tensor_type.elem_type 从 float 改为 uint8，其它字段原样保留
+    bool patch_tensor_type(std::string_view tensor_type, std::string& out)
+    {
+        bool found = false;
+        Field field;
+        while (!tensor_type.empty()) {
+            if (!next_field(tensor_type, field)) {
+                return false;
+            }
+            if (field.number == kTensorTypeElemType && field.wire_type == kWireVarint) {
+                if (field.varint != kElemFloat) {
+                    return false;
+                }
+                write_varint_field(out, kTensorTypeElemType, kElemUint8);
+                found = true;
+            } else {
+                out.append(field.raw);
+            }
+        }
+        return found;
+    }
+
+    bool patch_type(std::string_view type, std::string& out)
+    {
+        bool found = false;
+        Field field;
+        while (!type.empty()) {
+            if (!next_field(type, field)) {
+                return false;
+            }
+            if (field.number == kTypeTensor && field.wire_type == kWireBytes) {
+                std::string tensor_type;
+                if (!patch_tensor_type(field.payload, tensor_type)) {
+                    return false;
+                }
+                write_bytes_field(out, kTypeTensor, tensor_type);
+                found = true;
+            } else {
+                out.append(field.raw);
+            }
+        }
+        return found;
+    }
+
+    // 改写输入的名称和元素类型
+    bool patch_value_info(std::string_view value_info, std::string_view new_name, std::string& out)
+    {
+        bool found_type = false;
+        Field field;
+        while (!value_info.empty()) {
+            if (!next_field(value_info, field)) {
+                return false;
+            }
+            if (field.number == kValueInfoName && field.wire_type == kWireBytes) {
+                write_bytes_field(out, kValueInfoName, new_name);
+            } else if (field.number == kValueInfoType && field.wire_type == kWireBytes) {
+                std::string type;
+                if (!patch_type(field.payload, type)) {
+                    return false;
+                }
+                write_bytes_field(out, kValueInfoType, type);
+                found_type = true;
+            } else {
+                out.append(field.raw);
+            }
+        }
+        return found_type;
+    }
+
+    std::string make_node(std::string_view op_type, std::string_view name,
+                          std::initializer_list<std::string_view> inputs, std::string_view output)
+    {
+        std::string node;
+        for (auto input : inputs) {
+            write_bytes_field(node, kNodeInput, input);
+        }
+        write_bytes_field(node, kNodeOutput, output);
+        write_bytes_field(node, kNodeName, name);
+        write_bytes_field(node, kNodeOpType, op_type);
+        return node;
+    }
+
+    std::string make_cast_node(std::string_view input, std::string_view output)
+    {
+        std::string node = make_node("Cast", std::string(output) + "_cast", {input}, output);
+        std::string attribute;
+        write_bytes_field(attribute, kAttributeName, "to");
+        write_varint_field(attribute, kAttributeInt, kElemFloat);
+        write_varint_field(attribute, kAttributeType, kAttributeTypeInt);
+        write_bytes_field(node, kNodeAttribute, attribute);
+        return node;
+    }
+
+    // 标量 float 初始值
+    std::string make_scalar_initializer(std::string_view name, float value)
+    {
+        std::string tensor;
+        write_varint_field(tensor, kTensorDataType, kElemFloat);
+        char bytes[sizeof(float)];
+        std::memcpy(bytes, &value, sizeof(float));
+        write_bytes_field(tensor, kTensorFloatData, std::string_view(bytes, sizeof(float)));
+        write_bytes_field(tensor, kTensorName, name);
+        return tensor;
+    }
+
+    bool patch_graph(std::string_view graph, std::string& out)
+    {
+        // 第一遍：收集已占用的名称，找到第一个不是初始值的输入
+        std::unordered_set<std::string_view> initializers;
+        std::unordered_set<std::string_view> names;
+        std::vector<Field> inputs;
+        Field field;
+        for (std::string_view rest = graph; !rest.empty();) {
+            if (!next_field(rest, field)) {
+                return false;
+            }
+            if (field.wire_type != kWireBytes) {
+                continue;
+            }
+            std::string_view name;
+            if (field.number == kGraphInitializer && find_bytes(field.payload, kTensorName, name)) {
+                initializers.insert(name);
+                names.insert(name);
+            } else if (field.number == kGraphInput && find_bytes(field.payload, kValueInfoName, name)) {
+                inputs.push_back(field);
+                names.insert(name);
+            } else if (field.number == kGraphNode) {
+                std::string_view node = field.payload;
+                Field node_field;
+                while (!node.empty() && next_field(node, node_field)) {
+                    if (node_field.number == kNodeOutput && node_field.wire_type == kWireBytes) {
+                        names.insert(node_field.payload);
+                    }
+                }
+            }
+        }
+
+        const char* target = nullptr;
+        std::string_view input_name;
+        for (const auto& input : inputs) {
+            std::string_view name;
+            find_bytes(input.payload, kValueInfoName, name);
+            if (!initializers.contains(name)) {
+                target = input.raw.data();
+                input_name = name;
+                break;
+            }
+        }
+        if (target == nullptr) {
+            return false;
+        }
+
+        const std::string name(input_name);
+        const std::string uint8_name = name + "_uint8";
+        const std::string float_name = name + "_float";
+        const std::string scale_name = name + "_scale";
+        for (const auto& added : {uint8_name, float_name, scale_name}) {
+            if (names.contains(added)) {
+                return false;
+            }
+        }
+
+        // 第二遍：新节点放在最前面保持拓扑顺序，原输入改写，其余字段原样拷贝
+        std::string patched;
+        patched.reserve(graph.size() + 256);
+        write_bytes_field(patched, kGraphNode, make_cast_node(uint8_name, float_name));
+        write_bytes_field(patched, kGraphNode, make_node("Mul", name + "_normalize", {float_name, scale_name}, name));
+        for (std::string_view rest = graph; !rest.empty();) {
+            if (!next_field(rest, field)) {
+                return false;
+            }
+            if (field.raw.data() == target) {
+                std::string value_info;
+                if (!patch_value_info(field.payload, uint8_name, value_info)) {
+                    return false;
+                }
+                write_bytes_field(patched, kGraphInput, value_info);
+            } else {
+                patched.append(field.raw);
+            }
+        }
+        write_bytes_field(patched, kGraphInitializer,
+                          make_scalar_initializer(scale_name, static_cast<float>(1.0 / 255.0)));
+        out = std::move(patched);
+        return true;
+    }
+
+    // 默认算子集版本过低时 Mul 不支持标量广播
+    bool opset_supported(std::string_view opset)
+    {
+        std::string_view domain;
+        uint64_t version = 0;
+        Field field;
+        while (!opset.empty()) {
+            if (!next_field(opset, field)) {
+                return false;
+            }
+            if (field.number == kOpsetDomain && field.wire_type == kWireBytes) {
+                domain = field.payload;
+            } else if (field.number == kOpsetVersion && field.wire_type == kWireVarint) {
+                version = field.varint;
+            }
+        }
+        return !(domain.empty() || domain == "ai.onnx") || version >= kMinOpset;
+    }
+}
+
+bool patch_uint8_input(const void* model_data, size_t model_size, std::string& out)
+{
+    if (model_data == nullptr || model_size == 0) {
+        return false;
+    }
+    std::string_view model(static_cast<const char*>(model_data), model_size);
+
+    std::string result;
+    result.reserve(model_size + 256);
+    bool patched = false;
+    Field field;
+    while (!model.empty()) {
+        if (!next_field(model, field)) {
+            return false;
+        }
+        if (field.number == kModelOpsetImport && field.wire_type == kWireBytes && !opset_supported(field.payload)) {
+            return false;
+        }
+        if (field.number == kModelGraph && field.wire_type == kWireBytes && !patched) {
+            std::string graph;
+            if (!patch_graph(field.payload, graph)) {
+                return false;
+            }
+            write_bytes_field(result, kModelGraph, graph);
+            patched = true;
+        } else {
+            result.append(field.raw);
+        }
+    }
+    if (!patched) {
+        return false;
+    }
+    out = std::move(result);
+    return true;
+}
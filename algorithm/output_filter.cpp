@@ -0,0 +1,179 @@
+//
+// Created by JellyfishKnight on 25-7-8.
+//
+#include "output_filter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <numbers>
+
+namespace
+{
+    // dt 异常（首帧或计时抖动为 0）时使用的最小时间步长
+    constexpr double kMinDt = 1e-3;
+
+    // 一阶低通的平滑系数
+    float smoothing_alpha(float cutoff, double dt)
+    {
+        double tau = 1.0 / (2.0 * std::numbers::pi * std::max(cutoff, 1e-3f));
+        return static_cast<float>(1.0 / (1.0 + tau / dt));
+    }
+}
+
+const OutputFilterConfig& OutputFilterSettings::for_group(const std::string& group) const
+{
+    auto it = groups.find(group);
+    return it != groups.end() ? it->second : defaults;
+}
+
+KalmanOutputFilter::KalmanOutputFilter(size_t channels)
+    : bank_(channels)
+{
+}
+
+void KalmanOutputFilter::reset()
+{
+    initialized_ = false;
+}
+
+void KalmanOutputFilter::apply(std::span<float> values, const FilterStep& step)
+{
+    if (!initialized_) {
+        // 以当前测量作为初始位置，速度从零开始
+        bank_.set_state(values);
+        initialized_ = true;
+    }
+    bank_.predict(step.dt, step.q_factor);
+    bank_.correct(values, step.r_factor);
+    auto positions = bank_.positions();
+    for (size_t i = 0; i < values.size() && i < positions.size(); i++) {
+        values[i] = static_cast<float>(positions[i]);
+    }
+}
+
+bool KalmanOutputFilter::velocities(std::span<float> out) const
+{
+    auto velocity = bank_.velocities();
+    for (size_t i = 0; i < out.size() && i < velocity.size(); i++) {
+        out[i] = static_cast<float>(velocity[i]);
+    }
+    return initialized_;
+}
+
+OneEuroOutputFilter::OneEuroOutputFilter(size_t channels, const OutputFilterConfig& config)
+    : config_(config), value_(channels, 0.0f), derivative_(channels, 0.0f)
+{
+}
+
+void OneEuroOutputFilter::reset()
+{
+    initialized_ = false;
+}
+
+void OneEuroOutputFilter::apply(std::span<float> values, const FilterStep& step)
+{
+    const size_t n = std::min(values.size(), value_.size());
+    if (!initialized_) {
+        std::copy_n(values.begin(), n, value_.begin());
+        std::fill(derivative_.begin(), derivative_.end(), 0.0f);
+        initialized_ = true;
+        return;
+    }
+    const double dt = std::max(step.dt, kMinDt);
+    const float derivative_alpha = smoothing_alpha(config_.d_cutoff, dt);
+    for (size_t i = 0; i < n; i++) {
+        // 先平滑速度，再由速度决定本帧的截止频率
+        float derivative = static_cast<float>((values[i] - value_[i]) / dt);
+        derivative_[i] += derivative_alpha * (derivative - derivative_[i]);
+        float cutoff = config_.min_cutoff + config_.beta * std::abs(derivative_[i]);
+        value_[i] += smoothing_alpha(cutoff, dt) * (values[i] - value_[i]);
+        values[i] = value_[i];
+    }
+}
+
+bool OneEuroOutputFilter::velocities(std::span<float> out) const
+{
+    std::copy_n(derivative_.begin(), std::min(out.size(), derivative_.size()), out.begin());
+    return initialized_;
+}
+
+std::unique_ptr<OutputFilter> make_output_filter(const OutputFilterConfig& config, size_t channels)
+{
+    switch (config.type) {
+    case OutputFilterType::Kalman:
+        return std::make_unique<KalmanOutputFilter>(channels);
+    case OutputFilterType::OneEuro:
+        return std::make_unique<OneEuroOutputFilter>(channels, config);
+    case OutputFilterType::None:
+        break;
+    }
+    return nullptr;
+}
+
+void GroupedOutputFilter::configure(std::span<const std::string> channel_groups, const OutputFilterSettings& settings)
+{
+    groups_.clear();
+    std::vector<std::string> names;
+    for (size_t channel = 0; channel < channel_groups.size(); channel++) {
+        const std::string& name = channel_groups[channel];
+        if (settings.for_group(name).type == OutputFilterType::None) {
+            continue;
+        }
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it == names.end()) {
+            names.push_back(name);
+            groups_.emplace_back();
+            it = names.end() - 1;
+        }
+        groups_[it - names.begin()].channels.push_back(channel);
+    }
+    for (size_t i = 0; i < groups_.size(); i++) {
+        Group& group = groups_[i];
+        group.values.resize(group.channels.size());
+        group.filter = make_output_filter(settings.for_group(names[i]), group.channels.size());
+    }
+}
+
+void GroupedOutputFilter::reset()
+{
+    for (auto& group : groups_) {
+        group.filter->reset();
+    }
+}
+
+void GroupedOutputFilter::apply(std::span<float> values, const FilterStep& step)
+{
+    for (auto& group : groups_) {
+        // 分组的通道不一定连续，先收集到分组缓冲区，滤波后写回
+        for (size_t i = 0; i < group.channels.size(); i++) {
+            group.values[i] = group.channels[i] < values.size() ? values[group.channels[i]] : 0.0f;
+        }
+        group.filter->apply(group.values, step);
+        for (size_t i = 0; i < group.channels.size(); i++) {
+            if (group.channels[i] < values.size()) {
+                values[group.channels[i]] = group.values[i];
+            }
+        }
+    }
+}
+
+void GroupedOutputFilter::velocities(std::span<float> out)
+{
+    std::fill(out.begin(), out.end(), 0.0f);
+    for (auto& group : groups_) {
+        if (!group.filter->velocities(group.values)) {
+            continue;
+        }
+        for (size_t i = 0; i < group.channels.size(); i++) {
+            if (group.channels[i] < out.size()) {
+                out[group.channels[i]] = group.values[i];
+            }
+        }
+    }
+}
+
+std::string blendshape_group(const std::string& name)
+{
+    auto it = std::find_if(name.begin(), name.end(), [](unsigned char c) { return std::isupper(c); });
+    return std::string(name.begin(), it);
+}
@@ -0,0 +1,63 @@
+//
+// Created by JellyfishKnight on 25-7-9.
+//
+#include "output_transform.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    constexpr float kInfinity = std::numeric_limits<float>::infinity();
+    // 增益滑条每一格对应的放大比例
+    constexpr float kAmpStep = 0.02f;
+    // tongueRight 输出偏小，固定放大 2.5 倍
+    constexpr float kTongueRightGain = 2.5f;
+}
+
+OutputTransform OutputTransform::compile(const std::vector<std::string>& names,
+                                         const std::unordered_map<std::string, float>& offset_map,
+                                         const std::unordered_map<std::string, int>& amp_map)
+{
+    const size_t n = names.size();
+    OutputTransform transform;
+    transform.offset.assign(n, 0.0f);
+    transform.lower.assign(n, -kInfinity);
+    transform.upper.assign(n, kInfinity);
+    transform.gain.assign(n, 1.0f);
+    transform.limit.assign(n, kInfinity);
+    for (size_t i = 0; i < n; i++) {
+        // 应用偏置值，确保结果在0-1之间
+        if (auto it = offset_map.find(names[i]); it != offset_map.end()) {
+            transform.offset[i] = it->second;
+            transform.lower[i] = 0.0f;
+            transform.upper[i] = 1.0f;
+        }
+        // 增益放大后不超过 1
+        if (auto it = amp_map.find(names[i]); it != amp_map.end() && it->second != 0) {
+            transform.gain[i] *= static_cast<float>(it->second * kAmpStep + 1.0);
+            transform.limit[i] = 1.0f;
+        }
+        // 先限幅再放大 2.5 倍与直接合并增益后限幅结果相同
+        if (names[i] == "tongueRight") {
+            transform.gain[i] *= kTongueRightGain;
+            transform.limit[i] = 1.0f;
+        }
+    }
+    return transform;
+}
+
+void OutputTransform::apply(std::span<float> values) const
+{
+    const size_t n = std::min(values.size(), size());
+    float* x = values.data();
+    const float* off = offset.data();
+    const float* lo = lower.data();
+    const float* hi = upper.data();
+    const float* g = gain.data();
+    const float* lim = limit.data();
+    // 无分支的逐元素运算，编译器可以向量化
+    for (size_t i = 0; i < n; i++) {
+        float v = std::min(std::max(x[i] + off[i], lo[i]), hi[i]);
+        x[i] = std::min(v * g[i], lim[i]);
+    }
+}
@@ -0,0 +1,266 @@
+//
+// Created by JellyfishKnight on 25-7-5.
+//
+#include "session_tuner.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <QSysInfo>
+
+namespace
+{
+    constexpr const char* kTuningFile = "./session_tuning.json";
+    constexpr int kWarmupRuns = 3;
+    constexpr int kMeasureRuns = 20;
+}
+
+void SessionTuning::apply(Ort::SessionOptions& options) const
+{
+    if (intra_op_threads > 0) {
+        options.SetIntraOpNumThreads(intra_op_threads);
+        options.AddConfigEntry("session.intra_op.allow_spinning", allow_spinning ? "1" : "0");
+    } else {
+        // 线程数和自旋由全局线程池决定
+        options.DisablePerSessionThreads();
+    }
+    if (mem_pattern) {
+        options.EnableMemPattern();
+    } else {
+        options.DisableMemPattern();
+    }
+    options.SetExecutionMode(parallel_execution ? ExecutionMode::ORT_PARALLEL : ExecutionMode::ORT_SEQUENTIAL);
+}
+
+std::string SessionTuning::tag() const
+{
+    return std::format("t{}s{}m{}{}", intra_op_threads, allow_spinning ? 1 : 0, mem_pattern ? 1 : 0,
+                       parallel_execution ? "p" : "q");
+}
+
+bool SessionTuning::parse(const std::string& text, SessionTuning& tuning)
+{
+    SessionTuning result = tuning;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        auto pos = item.find('=');
+        if (pos == std::string::npos) {
+            return false;
+        }
+        std::string key = item.substr(0, pos);
+        std::string value = item.substr(pos + 1);
+        try {
+            int number = std::stoi(value);
+            if (key == "threads") {
+                result.intra_op_threads = std::max(0, number);
+            } else if (key == "spinning") {
+                result.allow_spinning = number != 0;
+            } else if (key == "mem_pattern") {
+                result.mem_pattern = number != 0;
+            } else if (key == "parallel") {
+                result.parallel_execution = number != 0;
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    tuning = result;
+    return true;
+}
+
+SessionTuner& SessionTuner::instance()
+{
+    static SessionTuner tuner;
+    return tuner;
+}
+
+SessionTuner::SessionTuner()
+    : writer_(kTuningFile), machine_id_(current_machine_id())
+{
+}
+
+std::string SessionTuner::current_machine_id()
+{
+    return std::format("{}|{}|{}", QSysInfo::machineHostName().toStdString(),
+                       QSysInfo::currentCpuArchitecture().toStdString(),
+                       std::thread::hardware_concurrency());
+}
+
+void SessionTuner::set_override(const SessionTuning& tuning)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    override_ = tuning;
+}
+
+void SessionTuner::request_retune()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    retune_ = true;
+}
+
+std::optional<SessionTuning> SessionTuner::explicit_tuning()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (override_) {
+        return override_;
+    }
+    auto file = writer_.get_config<SessionTuningFile>();
+    if (file.pinned) {
+        return file.pinned_tuning;
+    }
+    return std::nullopt;
+}
+
+SessionTuning SessionTuner::tuning_for(const std::string& model_key, const std::string& model_hash,
+                                       const SessionTuning& defaults, const Benchmark& benchmark)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (override_) {
+        LOG_INFO("会话参数由命令行指定: {} -> {}", model_key, override_->tag());
+        return *override_;
+    }
+
+    auto file = writer_.get_config<SessionTuningFile>();
+    if (file.pinned) {
+        LOG_INFO("会话参数由配置文件固定: {} -> {}", model_key, file.pinned_tuning.tag());
+        return file.pinned_tuning;
+    }
+
+    bool force = retune_ && !retuned_.contains(model_key);
+    if (file.machine_id == machine_id_ && !force) {
+        auto it = file.models.find(model_key);
+        if (it != file.models.end() && it->second.model_hash == model_hash) {
+            return it->second.tuning;
+        }
+    }
+    if (file.machine_id != machine_id_) {
+        // 换了机器，之前的结果全部作废
+        file.models.clear();
+        file.machine_id = machine_id_;
+    }
+
+    LOG_INFO("正在测试 {} 的会话参数，只在首次运行时进行...", model_key);
+    auto measure = [&](const SessionTuning& tuning) {
+        try {
+            double ms = benchmark(tuning);
+            LOG_DEBUG("  {}: {:.2f} ms", tuning.tag(), ms);
+            return ms;
+        } catch (const std::exception& e) {
+            LOG_WARN("  {} 测试失败: {}", tuning.tag(), e.what());
+            return std::numeric_limits<double>::infinity();
+        }
+    };
+
+    SessionTuning best = defaults;
+    double best_ms = measure(best);
+    auto try_candidate = [&](const SessionTuning& candidate) {
+        if (candidate.tag() == best.tag()) {
+            return;
+        }
+        double ms = measure(candidate);
+        if (ms < best_ms) {
+            best = candidate;
+            best_ms = ms;
+        }
+    };
+
+    // 逐项搜索：先确定线程数，再依次尝试其余开关
+    // 使用全局线程池时线程数和自旋由线程池决定，只测试其余开关
+    const bool shared_pool = defaults.intra_op_threads == 0;
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> thread_candidates{1, 2, 4, cores / 2};
+    // cores / 2 可能与前面的取值相同，每个线程数只测试一次
+    std::sort(thread_candidates.begin(), thread_candidates.end());
+    thread_candidates.erase(std::unique(thread_candidates.begin(), thread_candidates.end()), thread_candidates.end());
+    for (int threads : thread_candidates) {
+        if (!shared_pool && threads >= 1 && threads <= cores) {
+            SessionTuning candidate = best;
+            candidate.intra_op_threads = threads;
+            try_candidate(candidate);
+        }
+    }
+    for (int knob = shared_pool ? 1 : 0; knob < 3; knob++) {
+        SessionTuning candidate = best;
+        if (knob == 0) candidate.allow_spinning = !candidate.allow_spinning;
+        if (knob == 1) candidate.mem_pattern = !candidate.mem_pattern;
+        if (knob == 2) candidate.parallel_execution = !candidate.parallel_execution;
+        try_candidate(candidate);
+    }
+
+    if (!std::isfinite(best_ms)) {
+        LOG_WARN("{} 的会话参数测试全部失败，使用默认参数", model_key);
+        return defaults;
+    }
+    LOG_INFO("{} 最优会话参数: {}，中位耗时 {:.2f} ms", model_key, best.tag(), best_ms);
+    file.models[model_key] = SessionTuningRecord{model_hash, best, best_ms};
+    if (!writer_.write_config(file)) {
+        LOG_WARN("无法保存会话参数到 {}", kTuningFile);
+    }
+    retuned_.insert(model_key);
+    return best;
+}
+
+double SessionTuner::benchmark(Ort::Env& env, const void* model_data, size_t model_size,
+                               const Ort::SessionOptions& base_options, const SessionTuning& tuning,
+                               int batch_size)
+{
+    Ort::SessionOptions options = base_options.Clone();
+    tuning.apply(options);
+    Ort::Session session(env, model_data, model_size, options);
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
+    std::vector<std::string> input_names;
+    std::vector<std::string> output_names;
+    // 输入全零，按元素类型包装，uint8 输入的模型同样适用
+    std::vector<std::vector<uint8_t>> input_buffers(session.GetInputCount());
+    std::vector<Ort::Value> inputs;
+    for (size_t i = 0; i < session.GetInputCount(); i++) {
+        input_names.emplace_back(session.GetInputNameAllocated(i, allocator).get());
+        auto tensor_info = session.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo();
+        auto shape = tensor_info.GetShape();
+        size_t count = 1;
+        for (size_t j = 0; j < shape.size(); j++) {
+            // 动态批次维度按实际批次测试，其余动态维度按 1
+            if (shape[j] < 0) shape[j] = j == 0 ? std::max(1, batch_size) : 1;
+            count *= static_cast<size_t>(shape[j]);
+        }
+        auto element_type = tensor_info.GetElementType();
+        size_t element_size = element_type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 ? 1 : sizeof(float);
+        input_buffers[i].assign(count * element_size, 0);
+        inputs.push_back(Ort::Value::CreateTensor(memory_info, input_buffers[i].data(), input_buffers[i].size(),
+                                                  shape.data(), shape.size(), element_type));
+    }
+    for (size_t i = 0; i < session.GetOutputCount(); i++) {
+        output_names.emplace_back(session.GetOutputNameAllocated(i, allocator).get());
+    }
+    std::vector<const char*> input_ptrs;
+    std::vector<const char*> output_ptrs;
+    for (const auto& name : input_names) input_ptrs.push_back(name.c_str());
+    for (const auto& name : output_names) output_ptrs.push_back(name.c_str());
+
+    auto run_once = [&]() {
+        session.Run(Ort::RunOptions{nullptr}, input_ptrs.data(), inputs.data(), inputs.size(),
+                    output_ptrs.data(), output_ptrs.size());
+    };
+    for (int i = 0; i < kWarmupRuns; i++) {
+        run_once();
+    }
+    std::vector<double> times;
+    times.reserve(kMeasureRuns);
+    for (int i = 0; i < kMeasureRuns; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run_once();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
@@ -0,0 +1,121 @@
+//
+// Created by JellyfishKnight on 25-3-3.
+//
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * This file contains code from projectbabble:
+ * Copyright 2023 Sameer Suri
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef MAT_KALMAN_FILTER_HPP
+#define MAT_KALMAN_FILTER_HPP
+
+#include <functional>
+
+#include <opencv2/core.hpp>
+
+// 原推理类使用的 cv::Mat 卡尔曼滤波器，只作为基准和测试中的对照实现，不编入算法库
+// 矩阵由回调生成，每一步都会分配内存；状态向量的类型与 P 一致
+class MatKalmanFilter
+{
+public:
+    MatKalmanFilter() = default;
+
+    MatKalmanFilter(const std::function<cv::Mat(const cv::Mat&)>& TransMat,
+                    const std::function<cv::Mat(const cv::Mat&)>& MeasureMat,
+                    const std::function<cv::Mat()>& update_Q,
+                    const std::function<cv::Mat(const cv::Mat&)>& update_R, const cv::Mat& P)
+        : update_Q_(update_Q), update_R_(update_R), trans_mat_(TransMat), measure_mat_(MeasureMat), P_post_(P)
+    {
+        state_pre_ = cv::Mat::zeros(P.rows, 1, P.type());
+        state_post_ = cv::Mat::zeros(P.rows, 1, P.type());
+    }
+
+    void set_state(const cv::Mat& state) { state_post_ = state; }
+
+    cv::Mat predict()
+    {
+        // X_k_bar(先验估计) = A(状态转移矩阵) * X_k-1(后验估计)
+        F_ = trans_mat_(state_post_);
+        state_pre_ = F_ * state_post_;
+        Q_ = update_Q_();
+        // p_k_bar = A * p_k-1 * A_T + Q
+        P_pre_ = F_ * P_post_ * F_.t() + Q_;
+        state_post_ = state_pre_;
+        P_post_ = P_pre_;
+        return state_pre_;
+    }
+
+    cv::Mat correct(const cv::Mat& measurement)
+    {
+        // K_k = P_k_bar * H_T / (H * P_k_bar * H_T + R)
+        R_ = update_R_(measurement);
+        H_ = measure_mat_(state_pre_);
+        gain_ = P_pre_ * H_.t() * (H_ * P_pre_ * H_.t() + R_).inv();
+        // X_k = X_k_bar + K_k * (Z_k - H * X_k_bar)
+        state_post_ = state_pre_ + gain_ * (measurement - H_ * state_pre_);
+        // P_k = P_k_bar - K_k * H * P_k_bar
+        P_post_ = P_pre_ - gain_ * H_ * P_pre_;
+        return state_post_;
+    }
+
+    std::function<cv::Mat()> update_Q_;
+    std::function<cv::Mat(const cv::Mat&)> update_R_;
+    std::function<cv::Mat(const cv::Mat&)> trans_mat_;
+    std::function<cv::Mat(const cv::Mat&)> measure_mat_;
+
+    cv::Mat F_;  //状态转移矩阵
+    cv::Mat H_;  //测量转移矩阵
+    cv::Mat Q_;  //过程激励噪声协方差矩阵
+    cv::Mat R_;  //测量噪声协方差矩阵
+    cv::Mat P_pre_;
+    cv::Mat P_post_;
+    cv::Mat gain_;        //卡尔曼增益系数
+    cv::Mat state_pre_;   // k时刻先验估计
+    cv::Mat state_post_;  // k时刻后验估计
+};
+
+// 与原推理类中 init_kalman_filter 相同的 cv::Mat 常速度滤波器，状态为 [所有位置, 所有速度]
+template <typename Scalar>
+MatKalmanFilter make_mat_kalman_filter(int channels, double dt, double q_factor, double r_factor)
+{
+    const int type = cv::traits::Type<Scalar>::value;
+    const int state_size = channels * 2;
+    const double q2 = q_factor * q_factor;
+    auto update_Q = [=]() {
+        cv::Mat Q = cv::Mat::zeros(state_size, state_size, type);
+        cv::Mat I_pos = cv::Mat::eye(channels, channels, type);
+        Q(cv::Rect(0, 0, channels, channels)) = I_pos * (dt * dt * dt * dt / 4.0 * q2);
+        Q(cv::Rect(channels, 0, channels, channels)) = I_pos * (dt * dt * dt / 2.0 * q2);
+        Q(cv::Rect(0, channels, channels, channels)) = I_pos * (dt * dt * dt / 2.0 * q2);
+        Q(cv::Rect(channels, channels, channels, channels)) = I_pos * (dt * dt * q2);
+        return Q;
+    };
+    auto update_R = [=](const cv::Mat&) {
+        return cv::Mat(cv::Mat::eye(channels, channels, type) * r_factor);
+    };
+    auto TransMat = [=](const cv::Mat&) {
+        cv::Mat F = cv::Mat::eye(state_size, state_size, type);
+        F(cv::Rect(channels, 0, channels, channels)) = cv::Mat::eye(channels, channels, type) * dt;
+        return F;
+    };
+    auto MeasureMat = [=](const cv::Mat&) {
+        cv::Mat H = cv::Mat::zeros(channels, state_size, type);
+        cv::Mat::eye(channels, channels, type).copyTo(H(cv::Rect(0, 0, channels, channels)));
+        return H;
+    };
+    return MatKalmanFilter(TransMat, MeasureMat, update_Q, update_R, cv::Mat::eye(state_size, state_size, type));
+}
+
+#endif //MAT_KALMAN_FILTER_HPP
@@ -0,0 +1,684 @@
+//
+// Created by JellyfishKnight on 25-7-6.
+//
+// 无界面推理基准：回放采集的面捕/眼追图像，统计各阶段延迟分位数、吞吐量和每帧堆分配次数，
+// 并校验单次遍历预处理与 OpenCV 流程的结果是否逐位一致，对比各卡尔曼滤波实现的耗时。不需要摄像头和 GPU。
+//
+// 用法：papertracker_bench [--face-model=PATH] [--eye-model=PATH]
+//                         [--face-frames=DIR] [--eye-frames=DIR]
+//                         [--frames=N] [--warmup=N] [--no-filter] [--json=PATH]
+//                         [--ort-tuning=threads=..,spinning=..,mem_pattern=..,parallel=..]
+//                         [--ort-pool-threads=N] [--skip-face] [--skip-eye]
+//                         [--output-filter=kalman|one_euro|none] [--latency-prediction]
+//                         [--change-gate=THRESHOLD]
+//                         [--cascade-face-model=PATH] [--cascade-eye-model=PATH] [--uint8-input]
+//                         [--execution-provider=auto|cpu|xnnpack|dnnl|openvino] [--compare-providers]
+// 未指定图像目录或目录中没有图像时使用随机噪声图像
+//
+#include <execution_provider.hpp>
+#include <eye_inference.hpp>
+#include <face_inference.hpp>
+#include <fused_preprocess.hpp>
+#include <json.hpp>
+#include <kalman_filter.hpp>
+#include <kalman_filter_bank.hpp>
+#include <model_registry.hpp>
+#include <session_tuner.hpp>
+#include "mat_kalman_filter.hpp"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // 统计 operator new 调用次数，OpenCV 内部通过 fastMalloc 的分配不在此列
+    std::atomic<size_t> allocation_count{0};
+}
+
+void* operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+    using json = nlohmann::json;
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int kEyeBatch = 2;            // 左右眼
+    constexpr int kSyntheticFrames = 64;
+    constexpr int kPreprocessCheckFrames = 32;
+    constexpr int kPreprocessBenchIterations = 2000;
+    constexpr int kKalmanBenchIterations = 2000;
+
+    struct Options
+    {
+        std::string face_model = "./model/face_model.onnx";
+        std::string eye_model = "./model/eye_model.onnx";
+        std::string face_frames;
+        std::string eye_frames;
+        std::string json_path;
+        int frames = 1000;
+        int warmup = 50;
+        bool use_filter = true;
+        OutputFilterSettings output_filter;
+        // 帧差门控默认关闭，测量完整推理；用 --change-gate=<阈值> 开启
+        ChangeGateConfig change_gate;
+        // 指定小模型时开启级联推理
+        CascadeConfig face_cascade;
+        CascadeConfig eye_cascade;
+        // 模型改为 uint8 输入，预处理只写字节
+        bool uint8_input = false;
+        ExecutionProviderConfig execution_provider;
+        // 依次使用每个可用的 CPU 执行提供者运行模型基准
+        bool compare_providers = false;
+        bool run_face = true;
+        bool run_eye = true;
+    };
+
+    double elapsed_ms(Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // 一个阶段的所有样本
+    class StageStats
+    {
+    public:
+        void add(double value)
+        {
+            samples_.push_back(value);
+        }
+
+        json summary() const
+        {
+            if (samples_.empty()) {
+                return json{{"count", 0}};
+            }
+            std::vector<double> sorted = samples_;
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&sorted](double p) {
+                size_t index = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+                return sorted[std::clamp<size_t>(index, 1, sorted.size()) - 1];
+            };
+            double sum = 0;
+            for (double value : sorted) {
+                sum += value;
+            }
+            return json{
+                {"count", sorted.size()},
+                {"mean", sum / static_cast<double>(sorted.size())},
+                {"p50", percentile(0.50)},
+                {"p90", percentile(0.90)},
+                {"p99", percentile(0.99)},
+                {"max", sorted.back()},
+            };
+        }
+
+        void reserve(size_t count)
+        {
+            samples_.reserve(count);
+        }
+
+    private:
+        std::vector<double> samples_;
+    };
+
+    // 一个推理器的全部统计
+    struct BenchStats
+    {
+        StageStats preprocess;
+        StageStats run_model;
+        StageStats get_output;
+        StageStats filter;
+        StageStats total;
+        StageStats allocations;
+
+        void reserve(size_t count)
+        {
+            for (StageStats* stage : {&preprocess, &run_model, &get_output, &filter, &total, &allocations}) {
+                stage->reserve(count);
+            }
+        }
+    };
+
+    bool parse_options(int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; i++) {
+            std::string argument = argv[i];
+            auto value_of = [&argument](const std::string& prefix, std::string& value) {
+                if (!argument.starts_with(prefix)) {
+                    return false;
+                }
+                value = argument.substr(prefix.size());
+                return true;
+            };
+            std::string value;
+            try {
+                if (value_of("--face-model=", value)) {
+                    options.face_model = value;
+                } else if (value_of("--eye-model=", value)) {
+                    options.eye_model = value;
+                } else if (value_of("--face-frames=", value)) {
+                    options.face_frames = value;
+                } else if (value_of("--eye-frames=", value)) {
+                    options.eye_frames = value;
+                } else if (value_of("--json=", value)) {
+                    options.json_path = value;
+                } else if (value_of("--frames=", value)) {
+                    options.frames = std::max(1, std::stoi(value));
+                } else if (value_of("--warmup=", value)) {
+                    options.warmup = std::max(0, std::stoi(value));
+                } else if (value_of("--ort-tuning=", value)) {
+                    SessionTuning tuning;
+                    if (!SessionTuning::parse(value, tuning)) {
+                        std::cerr << "无法解析会话参数: " << value << std::endl;
+                        return false;
+                    }
+                    SessionTuner::instance().set_override(tuning);
+                } else if (value_of("--ort-pool-threads=", value)) {
+                    ModelRegistry::set_global_pool_threads(std::max(0, std::stoi(value)));
+                } else if (value_of("--output-filter=", value)) {
+                    if (value == "kalman") {
+                        options.output_filter.defaults.type = OutputFilterType::Kalman;
+                    } else if (value == "one_euro") {
+                        options.output_filter.defaults.type = OutputFilterType::OneEuro;
+                    } else if (value == "none") {
+                        options.output_filter.defaults.type = OutputFilterType::None;
+                    } else {
+                        std::cerr << "未知的滤波算法: " << value << std::endl;
+                        return false;
+                    }
+                } else if (value_of("--change-gate=", value)) {
+                    options.change_gate.enabled = true;
+                    options.change_gate.threshold = std::stof(value);
+                } else if (value_of("--cascade-face-model=", value)) {
+                    options.face_cascade.enabled = true;
+                    options.face_cascade.fast_model = value;
+                } else if (value_of("--cascade-eye-model=", value)) {
+                    options.eye_cascade.enabled = true;
+                    options.eye_cascade.fast_model = value;
+                } else if (argument == "--latency-prediction") {
+                    options.output_filter.prediction.enabled = true;
+                } else if (value_of("--execution-provider=", value)) {
+                    if (!parse_execution_provider(value, options.execution_provider.provider)) {
+                        std::cerr << "未知的执行提供者: " << value << std::endl;
+                        return false;
+                    }
+                } else if (argument == "--compare-providers") {
+                    options.compare_providers = true;
+                } else if (argument == "--uint8-input") {
+                    options.uint8_input = true;
+                } else if (argument == "--no-filter") {
+                    options.use_filter = false;
+                } else if (argument == "--skip-face") {
+                    options.run_face = false;
+                } else if (argument == "--skip-eye") {
+                    options.run_eye = false;
+                } else {
+                    std::cerr << "未知参数: " << argument << std::endl;
+                    return false;
+                }
+            } catch (const std::exception&) {
+                std::cerr << "参数格式错误: " << argument << std::endl;
+                return false;
+            }
+        }
+        // 延迟补偿沿滤波器的速度外推，关闭滤波时不会运行，测得的耗时没有意义
+        if (options.output_filter.prediction.enabled && !options.use_filter) {
+            std::cerr << "--latency-prediction 需要开启输出滤波，不能与 --no-filter 同时使用" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // 读取目录中的全部图像，按文件名排序；没有图像时生成随机噪声图像
+    std::vector<cv::Mat> load_frames(const std::string& directory, cv::Size synthetic_size, const char* name)
+    {
+        std::vector<cv::Mat> frames;
+        std::error_code ec;
+        if (!directory.empty() && std::filesystem::is_directory(directory, ec)) {
+            std::vector<std::filesystem::path> paths;
+            for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+                auto extension = entry.path().extension().string();
+                std::transform(extension.begin(), extension.end(), extension.begin(),
+                               [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                if (extension == ".jpg" || extension == ".jpeg" || extension == ".png" || extension == ".bmp") {
+                    paths.push_back(entry.path());
+                }
+            }
+            std::sort(paths.begin(), paths.end());
+            for (const auto& path : paths) {
+                cv::Mat image = cv::imread(path.string(), cv::IMREAD_COLOR);
+                if (!image.empty()) {
+                    frames.push_back(std::move(image));
+                }
+            }
+        }
+        if (frames.empty()) {
+            std::cout << name << ": 未找到图像，使用 " << kSyntheticFrames << " 帧随机噪声图像" << std::endl;
+            cv::RNG rng(0x5eed);
+            for (int i = 0; i < kSyntheticFrames; i++) {
+                cv::Mat image(synthetic_size, CV_8UC3);
+                rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+                frames.push_back(std::move(image));
+            }
+        } else {
+            std::cout << name << ": 从 " << directory << " 读取 " << frames.size() << " 帧" << std::endl;
+        }
+        return frames;
+    }
+
+    json stats_to_json(const BenchStats& stats, int frames, double wall_ms)
+    {
+        return json{
+            {"frames", frames},
+            {"throughput_fps", wall_ms > 0 ? frames * 1000.0 / wall_ms : 0.0},
+            {"preprocess_ms", stats.preprocess.summary()},
+            {"run_model_ms", stats.run_model.summary()},
+            {"get_output_ms", stats.get_output.summary()},
+            {"kalman_ms", stats.filter.summary()},
+            {"total_ms", stats.total.summary()},
+            {"allocations_per_frame", stats.allocations.summary()},
+        };
+    }
+
+    // 单帧推理步骤：inference 部分和 get_output 部分分开计时
+    template <typename Infer, typename Output>
+    json run_bench(BaseInference& inference, const Options& options, size_t frame_count,
+                   const Infer& infer, const Output& output)
+    {
+        inference.set_dt(0.02f);
+        inference.set_use_filter(options.use_filter);
+        inference.set_output_filter(options.output_filter);
+        inference.set_change_gate(options.change_gate);
+        inference.set_stage_timing(true);
+        for (int i = 0; i < options.warmup; i++) {
+            infer(static_cast<size_t>(i) % frame_count);
+            output();
+        }
+        inference.take_stage_timings();
+        inference.take_change_gate_stats();
+        inference.take_cascade_stats();
+
+        BenchStats stats;
+        stats.reserve(options.frames);
+        auto wall_start = Clock::now();
+        for (int i = 0; i < options.frames; i++) {
+            size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+            auto start = Clock::now();
+            infer(static_cast<size_t>(i) % frame_count);
+            auto inferred = Clock::now();
+            output();
+            auto end = Clock::now();
+            size_t allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+            StageTimings timings = inference.take_stage_timings();
+            stats.preprocess.add(timings.preprocess_ms);
+            stats.run_model.add(timings.run_model_ms);
+            stats.get_output.add(elapsed_ms(inferred, end));
+            stats.filter.add(timings.filter_ms);
+            stats.total.add(elapsed_ms(start, end));
+            stats.allocations.add(static_cast<double>(allocations));
+        }
+        double wall_ms = elapsed_ms(wall_start, Clock::now());
+        inference.set_stage_timing(false);
+        json result = stats_to_json(stats, options.frames, wall_ms);
+        if (options.change_gate.enabled) {
+            ChangeGateStats gate = inference.take_change_gate_stats();
+            result["change_gate"] = json{
+                {"threshold", options.change_gate.threshold},
+                {"frames", gate.frames},
+                {"skipped", gate.skipped},
+                {"skip_rate", gate.skip_rate()},
+            };
+        }
+        CascadeStats cascade = inference.take_cascade_stats();
+        if (cascade.full_frames + cascade.fast_frames > 0) {
+            result["cascade"] = json{
+                {"full_frames", cascade.full_frames},
+                {"fast_frames", cascade.fast_frames},
+            };
+        }
+        return result;
+    }
+
+    json bench_face(const Options& options, const std::vector<cv::Mat>& frames)
+    {
+        FaceInference inference;
+        inference.set_cascade(options.face_cascade);
+        inference.set_uint8_input(options.uint8_input);
+        inference.set_execution_provider(options.execution_provider);
+        inference.load_model(options.face_model);
+        if (!inference.is_ready()) {
+            return json{{"error", "无法加载面捕模型: " + options.face_model}};
+        }
+        return run_bench(inference, options, frames.size(),
+            [&](size_t index) { inference.inference(frames[index]); },
+            [&]() { inference.get_output(); });
+    }
+
+    json bench_eye(const Options& options, const std::vector<cv::Mat>& frames)
+    {
+        EyeInference inference(kEyeBatch);
+        inference.set_cascade(options.eye_cascade);
+        inference.set_uint8_input(options.uint8_input);
+        inference.set_execution_provider(options.execution_provider);
+        inference.load_model(options.eye_model);
+        if (!inference.is_ready()) {
+            return json{{"error", "无法加载眼追模型: " + options.eye_model}};
+        }
+        json result;
+        if (inference.batch_size() == kEyeBatch) {
+            // 相邻两帧作为左右眼，一次 Run 完成
+            std::vector<cv::Mat> batch(kEyeBatch);
+            result = run_bench(inference, options, frames.size(),
+                [&](size_t index) {
+                    for (int slot = 0; slot < kEyeBatch; slot++) {
+                        batch[slot] = frames[(index + slot) % frames.size()];
+                    }
+                    inference.inference_batch(batch);
+                },
+                [&]() {
+                    for (int slot = 0; slot < kEyeBatch; slot++) {
+                        inference.get_output(slot);
+                    }
+                });
+        } else {
+            result = run_bench(inference, options, frames.size(),
+                [&](size_t index) { inference.inference(frames[index]); },
+                [&]() { inference.get_output(); });
+        }
+        result["batch_size"] = inference.batch_size();
+        return result;
+    }
+
+    // OpenCV 参考流程，与推理类中的回退路径一致
+    void reference_preprocess(const cv::Mat& input, float* dst, int dst_w, int dst_h)
+    {
+        cv::Mat gray;
+        cv::Mat resized;
+        if (input.channels() == 3) {
+            cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+        } else {
+            gray = input;
+        }
+        cv::resize(gray, resized, cv::Size(dst_w, dst_h), 0, 0, cv::INTER_NEAREST);
+        cv::Mat output(dst_h, dst_w, CV_32F, dst);
+        resized.convertTo(output, CV_32F, 1.0 / 255.0);
+    }
+
+    // 比较单次遍历预处理与 OpenCV 流程的输出，并测量两者的耗时
+    json check_preprocess(const std::vector<cv::Mat>& frames, int dst_w, int dst_h)
+    {
+        FusedPreprocessor fused;
+        std::vector<float> expected(static_cast<size_t>(dst_w) * dst_h);
+        std::vector<float> actual(expected.size());
+        std::vector<uchar> actual_bytes(expected.size());
+        const float scale = static_cast<float>(1.0 / 255.0);
+        size_t mismatches = 0;
+        int checked = 0;
+        for (const cv::Mat& frame : frames) {
+            if (checked >= kPreprocessCheckFrames) {
+                break;
+            }
+            // 同时覆盖整帧和非连续的 ROI
+            cv::Mat roi = frame(cv::Rect(frame.cols / 8, frame.rows / 8, frame.cols * 3 / 4, frame.rows * 3 / 4));
+            for (const cv::Mat* input : {&frame, &roi}) {
+                reference_preprocess(*input, expected.data(), dst_w, dst_h);
+                if (!fused.run(*input, actual.data(), dst_w, dst_h)) {
+                    return json{{"error", "单次遍历预处理不支持该输入格式"}};
+                }
+                // uint8 输出乘以模型内的 1/255 后也应与 OpenCV 流程一致
+                if (!fused.run(*input, actual_bytes.data(), dst_w, dst_h)) {
+                    return json{{"error", "单次遍历预处理不支持该输入格式"}};
+                }
+                for (size_t i = 0; i < expected.size(); i++) {
+                    if (expected[i] != actual[i] || expected[i] != static_cast<float>(actual_bytes[i]) * scale) {
+                        mismatches++;
+                    }
+                }
+            }
+            checked++;
+        }
+
+        const cv::Mat& sample = frames.front();
+        auto start = Clock::now();
+        for (int i = 0; i < kPreprocessBenchIterations; i++) {
+            reference_preprocess(sample, expected.data(), dst_w, dst_h);
+        }
+        double reference_us = elapsed_ms(start, Clock::now()) * 1000.0 / kPreprocessBenchIterations;
+        start = Clock::now();
+        for (int i = 0; i < kPreprocessBenchIterations; i++) {
+            fused.run(sample, actual.data(), dst_w, dst_h);
+        }
+        double fused_us = elapsed_ms(start, Clock::now()) * 1000.0 / kPreprocessBenchIterations;
+        start = Clock::now();
+        for (int i = 0; i < kPreprocessBenchIterations; i++) {
+            fused.run(sample, actual_bytes.data(), dst_w, dst_h);
+        }
+        double fused_uint8_us = elapsed_ms(start, Clock::now()) * 1000.0 / kPreprocessBenchIterations;
+
+        return json{
+            {"size", std::to_string(dst_w) + "x" + std::to_string(dst_h)},
+            {"backend", FusedPreprocessor::backend()},
+            {"frames_checked", checked},
+            {"mismatched_values", mismatches},
+            {"opencv_us", reference_us},
+            {"fused_us", fused_us},
+            {"fused_uint8_us", fused_uint8_us},
+        };
+    }
+
+    // 对比 cv::Mat 滤波器、定长模板滤波器和逐通道滤波器组：单步耗时、每步堆分配次数以及与滤波器组的最大偏差
+    template <size_t Channels, typename Scalar>
+    json bench_kalman(const char* name, double dt, double q_factor, double r_factor)
+    {
+        std::vector<std::array<Scalar, Channels>> measurements(kKalmanBenchIterations);
+        std::vector<std::vector<float>> measurements_float(kKalmanBenchIterations, std::vector<float>(Channels));
+        std::mt19937 rng(0x5eed);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        for (int i = 0; i < kKalmanBenchIterations; i++) {
+            for (size_t c = 0; c < Channels; c++) {
+                measurements_float[i][c] = uniform(rng);
+                measurements[i][c] = static_cast<Scalar>(measurements_float[i][c]);
+            }
+        }
+
+        KalmanFilterBank bank(Channels);
+        // 定长滤波器体积较大，放在堆上
+        auto fixed = std::make_unique<KalmanFilter<Channels * 2, Channels, Scalar>>();
+        fixed->set_constant_velocity(static_cast<Scalar>(dt), static_cast<Scalar>(q_factor), static_cast<Scalar>(r_factor));
+        MatKalmanFilter mat = make_mat_kalman_filter<Scalar>(static_cast<int>(Channels), dt, q_factor, r_factor);
+
+        double fixed_deviation = 0;
+        double mat_deviation = 0;
+        auto measure = [](const auto& step) {
+            size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+            auto start = Clock::now();
+            for (int i = 0; i < kKalmanBenchIterations; i++) {
+                step(i);
+            }
+            double us = elapsed_ms(start, Clock::now()) * 1000.0 / kKalmanBenchIterations;
+            double allocations = static_cast<double>(allocation_count.load(std::memory_order_relaxed) - allocations_before) /
+                                 kKalmanBenchIterations;
+            return json{{"step_us", us}, {"allocations_per_step", allocations}};
+        };
+
+        json result{{"name", name}, {"channels", Channels}, {"scalar", sizeof(Scalar) == 4 ? "float" : "double"}};
+        result["bank"] = measure([&](int i) {
+            bank.predict(dt, q_factor);
+            bank.correct(measurements_float[i], r_factor);
+        });
+        result["fixed"] = measure([&](int i) {
+            fixed->predict();
+            fixed->correct(measurements[i]);
+        });
+        result["mat"] = measure([&](int i) {
+            mat.predict();
+            mat.correct(cv::Mat(static_cast<int>(Channels), 1, cv::traits::Type<Scalar>::value, measurements[i].data()));
+        });
+
+        // 三者走同样的测量序列，比较最终位置
+        auto positions = bank.positions();
+        for (size_t c = 0; c < Channels; c++) {
+            fixed_deviation = std::max(fixed_deviation, std::abs(static_cast<double>(fixed->state()[c]) - positions[c]));
+            mat_deviation = std::max(mat_deviation, std::abs(static_cast<double>(mat.state_post_.at<Scalar>(static_cast<int>(c), 0)) - positions[c]));
+        }
+        result["fixed"]["max_deviation"] = fixed_deviation;
+        result["mat"]["max_deviation"] = mat_deviation;
+        return result;
+    }
+
+    void print_stage(const char* name, const json& stage)
+    {
+        if (!stage.contains("p50")) {
+            return;
+        }
+        std::printf("  %-22s p50 %9.3f  p90 %9.3f  p99 %9.3f  max %9.3f\n", name,
+                    stage["p50"].get<double>(), stage["p90"].get<double>(),
+                    stage["p99"].get<double>(), stage["max"].get<double>());
+    }
+
+    void print_result(const char* name, const json& result)
+    {
+        std::printf("\n[%s]\n", name);
+        if (result.contains("error")) {
+            std::printf("  错误: %s\n", result["error"].get<std::string>().c_str());
+            return;
+        }
+        std::printf("  帧数 %d，吞吐量 %.1f fps\n", result["frames"].get<int>(), result["throughput_fps"].get<double>());
+        print_stage("preprocess (ms)", result["preprocess_ms"]);
+        print_stage("run_model (ms)", result["run_model_ms"]);
+        print_stage("get_output (ms)", result["get_output_ms"]);
+        print_stage("kalman (ms)", result["kalman_ms"]);
+        print_stage("total (ms)", result["total_ms"]);
+        print_stage("allocations / frame", result["allocations_per_frame"]);
+    }
+
+    // 依次使用每个可用的 CPU 执行提供者运行同一基准，比较各自的推理耗时
+    json compare_providers(Options options, const std::vector<cv::Mat>& frames,
+                           json (*bench)(const Options&, const std::vector<cv::Mat>&))
+    {
+        json runs = json::array();
+        for (auto provider : available_cpu_execution_providers()) {
+            const char* name = execution_provider_name(provider);
+            options.execution_provider.provider = provider;
+            json result = bench(options, frames);
+            result["provider"] = name;
+            // 释放本次的会话，各执行提供者的会话不同时占用内存
+            ModelRegistry::instance().release_unused();
+            if (result.contains("error")) {
+                std::printf("  %-10s 错误: %s\n", name, result["error"].get<std::string>().c_str());
+            } else {
+                std::printf("  %-10s run_model p50 %9.3f  p90 %9.3f  total p50 %9.3f  %.1f fps\n", name,
+                            result["run_model_ms"]["p50"].get<double>(), result["run_model_ms"]["p90"].get<double>(),
+                            result["total_ms"]["p50"].get<double>(), result["throughput_fps"].get<double>());
+            }
+            runs.push_back(std::move(result));
+        }
+        return runs;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 2;
+    }
+
+    json report;
+    bool ok = true;
+
+    auto face_frames = load_frames(options.face_frames, cv::Size(280, 280), "face");
+    auto eye_frames = load_frames(options.eye_frames, cv::Size(240, 240), "eye");
+    // 预处理一致性检查不依赖模型
+    report["preprocess"] = json::array({check_preprocess(face_frames, 224, 224), check_preprocess(eye_frames, 112, 112)});
+    for (const auto& check : report["preprocess"]) {
+        if (check.contains("error")) {
+            std::printf("预处理检查失败: %s\n", check["error"].get<std::string>().c_str());
+            ok = false;
+            continue;
+        }
+        size_t mismatches = check["mismatched_values"].get<size_t>();
+        std::printf("预处理 %s [%s]: 不一致 %zu 个值，OpenCV %.1f us，单次遍历 %.1f us，uint8 输出 %.1f us\n",
+                    check["size"].get<std::string>().c_str(), check["backend"].get<std::string>().c_str(),
+                    mismatches, check["opencv_us"].get<double>(), check["fused_us"].get<double>(),
+                    check["fused_uint8_us"].get<double>());
+        ok = ok && mismatches == 0;
+    }
+
+    // 滤波器对比同样不依赖模型，参数与面捕、眼追推理类一致
+    report["kalman"] = json::array({bench_kalman<kBlendShapeCount, float>("face", 0.02, 0.5, 5e-5),
+                                    bench_kalman<EYE_OUTPUT_SIZE, double>("eye", 0.02, 5.0, 0.0003)});
+    for (const auto& kalman : report["kalman"]) {
+        std::printf("卡尔曼 %s (%d 通道, %s): 滤波器组 %.2f us，定长模板 %.2f us，cv::Mat %.2f us，每步分配 %.1f / %.1f / %.1f 次\n",
+                    kalman["name"].get<std::string>().c_str(), kalman["channels"].get<int>(),
+                    kalman["scalar"].get<std::string>().c_str(), kalman["bank"]["step_us"].get<double>(),
+                    kalman["fixed"]["step_us"].get<double>(), kalman["mat"]["step_us"].get<double>(),
+                    kalman["bank"]["allocations_per_step"].get<double>(),
+                    kalman["fixed"]["allocations_per_step"].get<double>(),
+                    kalman["mat"]["allocations_per_step"].get<double>());
+    }
+
+    if (options.run_face) {
+        report["face"] = bench_face(options, face_frames);
+        print_result("face", report["face"]);
+        ok = ok && !report["face"].contains("error");
+    }
+    if (options.run_eye) {
+        report["eye"] = bench_eye(options, eye_frames);
+        print_result("eye", report["eye"]);
+        ok = ok && !report["eye"].contains("error");
+    }
+
+    if (options.compare_providers) {
+        if (options.run_face) {
+            std::printf("\n[face 执行提供者对比]\n");
+            report["providers"]["face"] = compare_providers(options, face_frames, bench_face);
+        }
+        if (options.run_eye) {
+            std::printf("\n[eye 执行提供者对比]\n");
+            report["providers"]["eye"] = compare_providers(options, eye_frames, bench_eye);
+        }
+    }
+
+    if (!options.json_path.empty()) {
+        std::ofstream out(options.json_path);
+        out << report.dump(2) << std::endl;
+        if (!out) {
+            std::cerr << "无法写入 " << options.json_path << std::endl;
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -8,12 +8,36 @@
 #include <QApplication>
 #include <QThread>
 #include <updater.hpp>
+#include <model_registry.hpp>
 
 
 int main(int argc, char *argv[]) {
     system("chcp 65001");
     // Create ui application
     QApplication app(argc, argv);
+    // ORT 会话参数：--ort-tuning=threads=2,spinning=0,mem_pattern=0,parallel=0 固定参数，--ort-retune 重新测试，
+    // --ort-pool-threads=N 设置全局线程池大小（0 关闭全局线程池）；
+    // 使用全局线程池时自动测试只调整其余开关，固定参数中 threads 大于 0 的会话改用自己的线程池
+    for (const auto& argument : QApplication::arguments()) {
+        if (argument.startsWith("--ort-tuning=")) {
+            SessionTuning tuning;
+            if (SessionTuning::parse(argument.mid(13).toStdString(), tuning)) {
+                SessionTuner::instance().set_override(tuning);
+            } else {
+                LOG_WARN("无法解析会话参数: {}", argument.toStdString());
+            }
+        } else if (argument == "--ort-retune") {
+            SessionTuner::instance().request_retune();
+        } else if (argument.startsWith("--ort-pool-threads=")) {
+            bool ok = false;
+            int threads = argument.mid(19).toInt(&ok);
+            if (ok && threads >= 0) {
+                ModelRegistry::set_global_pool_threads(threads);
+            } else {
+                LOG_WARN("无法解析全局线程池大小: {}", argument.toStdString());
+            }
+        }
+    }
     QFile qssFile("./resources/material.qss"); // 使用资源路径
     QIcon icon("./resources/window_icon.png");
     if (qssFile.open(QFile::ReadOnly)) {
@@ -0,0 +1,19 @@
+//
+// Created by JellyfishKnight on 25-7-13.
+//
+// 算法库单元测试，由 ctest 运行，任一检查失败时返回非零
+//
+#include "test_common.hpp"
+
+int main()
+{
+    test_fused_preprocess();
+    test_kalman_filter_bank();
+
+    if (test_failures() != 0) {
+        std::printf("%d 项检查失败\n", test_failures());
+        return 1;
+    }
+    std::printf("全部通过\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+//
+// Created by JellyfishKnight on 25-7-13.
+//
+// 单次遍历预处理与 cvtColor -> resize(INTER_NEAREST) -> convertTo 的逐位一致性，
+// 标量、SSE2、AVX2 三条路径分别校验（CPU 不支持的路径跳过）
+//
+#include "test_common.hpp"
+#include <fused_preprocess.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    cv::Mat reference_gray(const cv::Mat& src, int dst_w, int dst_h)
+    {
+        cv::Mat gray;
+        if (src.channels() == 3) {
+            cv::cvtColor(src, gray, cv::COLOR_BGR2GRAY);
+        } else {
+            gray = src;
+        }
+        cv::Mat resized;
+        cv::resize(gray, resized, cv::Size(dst_w, dst_h), 0, 0, cv::INTER_NEAREST);
+        return resized;
+    }
+
+    // 返回第一个不一致的下标，全部一致时返回 -1
+    template <typename T>
+    long first_mismatch(const cv::Mat& expected, const std::vector<T>& actual)
+    {
+        for (int y = 0; y < expected.rows; y++) {
+            const T* row = expected.ptr<T>(y);
+            const T* out = actual.data() + static_cast<size_t>(y) * expected.cols;
+            // 浮点按位比较
+            if (std::memcmp(row, out, sizeof(T) * expected.cols) != 0) {
+                for (int x = 0; x < expected.cols; x++) {
+                    if (std::memcmp(row + x, out + x, sizeof(T)) != 0) {
+                        return static_cast<long>(y) * expected.cols + x;
+                    }
+                }
+            }
+        }
+        return -1;
+    }
+
+    void check_case(FusedPreprocessor::Backend backend, const cv::Mat& src, int dst_w, int dst_h, const char* kind)
+    {
+        const char* name = FusedPreprocessor::backend_name(backend);
+        const cv::Mat expected_u8 = reference_gray(src, dst_w, dst_h);
+        cv::Mat expected_f32;
+        expected_u8.convertTo(expected_f32, CV_32F, 1.0 / 255.0);
+
+        // 每个用例使用新的对象，同时覆盖坐标表的首次计算
+        FusedPreprocessor fused(backend);
+        CHECK(fused.active_backend() == backend, "%s 未生效", name);
+
+        std::vector<float> actual_f32(static_cast<size_t>(dst_w) * dst_h, -1.0f);
+        CHECK(fused.run(src, actual_f32.data(), dst_w, dst_h), "%s float 输出失败", name);
+        long index = first_mismatch(expected_f32, actual_f32);
+        CHECK(index < 0, "%s %s %dx%dx%d -> %dx%d float 输出在下标 %ld 处不一致", name, kind,
+              src.cols, src.rows, src.channels(), dst_w, dst_h, index);
+
+        std::vector<uchar> actual_u8(static_cast<size_t>(dst_w) * dst_h, 0);
+        CHECK(fused.run(src, actual_u8.data(), dst_w, dst_h), "%s uint8 输出失败", name);
+        index = first_mismatch(expected_u8, actual_u8);
+        CHECK(index < 0, "%s %s %dx%dx%d -> %dx%d uint8 输出在下标 %ld 处不一致", name, kind,
+              src.cols, src.rows, src.channels(), dst_w, dst_h, index);
+    }
+}
+
+void test_fused_preprocess()
+{
+    // 奇数宽度、不足一个向量宽度的行，以及放大（最后若干输出列都落在源行最后一个像素上，
+    // 只能走 safe_cols_ 之后的标量尾部）
+    const std::vector<std::pair<int, int>> src_sizes = {
+        {1, 1}, {2, 3}, {3, 5}, {7, 3}, {17, 9}, {33, 31}, {127, 65}, {240, 240}, {641, 479}, {5, 400},
+    };
+    const std::vector<std::pair<int, int>> dst_sizes = {
+        {1, 1}, {3, 3}, {7, 5}, {9, 300}, {112, 112}, {113, 111}, {224, 224},
+    };
+    const FusedPreprocessor::Backend backends[] = {
+        FusedPreprocessor::Backend::Scalar,
+        FusedPreprocessor::Backend::Sse2,
+        FusedPreprocessor::Backend::Avx2,
+    };
+
+    cv::theRNG().state = 0x5eed;
+    int checked_backends = 0;
+    for (auto backend : backends) {
+        if (!FusedPreprocessor::supports(backend)) {
+            std::printf("跳过 %s：当前 CPU 不支持\n", FusedPreprocessor::backend_name(backend));
+            continue;
+        }
+        ++checked_backends;
+        for (auto [src_w, src_h] : src_sizes) {
+            for (int channels : {1, 3}) {
+                // 像素放在恰好等长的缓冲区中，最后一行的行尾就是缓冲区末尾，越界读取可被 ASan 发现
+                std::vector<uchar> storage(static_cast<size_t>(src_w) * src_h * channels);
+                cv::Mat src(src_h, src_w, CV_8UC(channels), storage.data());
+                cv::randu(src, 0, 256);
+
+                // 同一缓冲区内的 ROI：行不连续，右边界就是父图像的行尾
+                cv::Mat roi;
+                if (src_w > 2 && src_h > 2) {
+                    roi = src(cv::Rect(2, 1, src_w - 2, src_h - 2));
+                }
+
+                for (auto [dst_w, dst_h] : dst_sizes) {
+                    check_case(backend, src, dst_w, dst_h, "整图");
+                    if (!roi.empty()) {
+                        check_case(backend, roi, dst_w, dst_h, "ROI");
+                    }
+                }
+            }
+        }
+    }
+    CHECK(checked_backends > 0, "没有可用的预处理实现");
+
+    // 不支持的输入返回 false，由调用者回退
+    FusedPreprocessor fused;
+    std::vector<float> out(4);
+    CHECK(!fused.run(cv::Mat(2, 2, CV_32FC1, cv::Scalar(0)), out.data(), 2, 2), "CV_32F 输入应被拒绝");
+    CHECK(!fused.run(cv::Mat(2, 2, CV_8UC4, cv::Scalar(0)), out.data(), 2, 2), "4 通道输入应被拒绝");
+}
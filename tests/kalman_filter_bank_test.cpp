@@ -0,0 +1,74 @@
+//
+// Created by JellyfishKnight on 25-7-13.
+//
+// 逐通道滤波器组与原推理类的稠密 cv::Mat 滤波器在同一测量序列上的数值一致性
+//
+#include "test_common.hpp"
+#include <kalman_filter_bank.hpp>
+#include "mat_kalman_filter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // 稠密滤波器每步都要做 2N x 2N 的矩阵乘法和 N x N 求逆，累计误差远小于该值
+    constexpr double kTolerance = 1e-9;
+
+    void check_sequence(int channels, double dt, double q_factor, double r_factor, int steps)
+    {
+        KalmanFilterBank bank(static_cast<size_t>(channels));
+        MatKalmanFilter dense = make_mat_kalman_filter<double>(channels, dt, q_factor, r_factor);
+
+        std::mt19937 rng(0x5eed + channels);
+        std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+        std::vector<float> measurement(channels);
+        cv::Mat dense_measurement(channels, 1, CV_64F);
+
+        double max_position_diff = 0;
+        double max_velocity_diff = 0;
+        for (int step = 0; step < steps; step++) {
+            for (int c = 0; c < channels; c++) {
+                // 带噪声的慢变信号，中途有一次阶跃
+                float value = 0.5f + 0.4f * std::sin(0.05f * step + c) + noise(rng);
+                if (step >= steps / 2 && c % 3 == 0) {
+                    value = 1.0f - value;
+                }
+                measurement[c] = value;
+                dense_measurement.at<double>(c, 0) = value;
+            }
+
+            bank.predict(dt, q_factor);
+            dense.predict();
+            bank.correct(measurement, r_factor);
+            dense.correct(dense_measurement);
+
+            auto positions = bank.positions();
+            auto velocities = bank.velocities();
+            for (int c = 0; c < channels; c++) {
+                max_position_diff = std::max(max_position_diff,
+                                             std::abs(positions[c] - dense.state_post_.at<double>(c, 0)));
+                max_velocity_diff = std::max(max_velocity_diff,
+                                             std::abs(velocities[c] - dense.state_post_.at<double>(channels + c, 0)));
+            }
+        }
+
+        CHECK(max_position_diff < kTolerance, "%d 通道 dt=%g q=%g r=%g 位置最大偏差 %g", channels, dt, q_factor,
+              r_factor, max_position_diff);
+        CHECK(max_velocity_diff < kTolerance, "%d 通道 dt=%g q=%g r=%g 速度最大偏差 %g", channels, dt, q_factor,
+              r_factor, max_velocity_diff);
+    }
+}
+
+void test_kalman_filter_bank()
+{
+    // 面捕默认参数（FilterStep：q = 0.5，r = 5e-5），R 很小时稠密求逆与闭式计算最容易出现差异
+    check_sequence(45, 1.0 / 60.0, 0.5, 5e-5, 600);
+    // 眼追每个槽位 EYE_OUTPUT_SIZE = 14 个通道，EyeInference 默认 q = 5，r = 3e-4
+    check_sequence(14, 0.02, 5.0, 3e-4, 600);
+    // 其它噪声比
+    check_sequence(45, 1.0 / 60.0, 0.5, 0.1, 600);
+    check_sequence(45, 1.0 / 30.0, 2.0, 0.01, 300);
+    check_sequence(2, 1.0 / 60.0, 0.5, 1.0, 600);
+}
@@ -0,0 +1,31 @@
+//
+// Created by JellyfishKnight on 25-7-13.
+//
+
+#ifndef TEST_COMMON_HPP
+#define TEST_COMMON_HPP
+
+#include <cstdio>
+
+// 不依赖测试框架：检查失败时打印位置并计数，main 按失败数返回非零
+inline int& test_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond, ...)                                                        \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            ++test_failures();                                                  \
+            std::printf("%s:%d: CHECK(%s) 失败: ", __FILE__, __LINE__, #cond);  \
+            std::printf(__VA_ARGS__);                                           \
+            std::printf("\n");                                                  \
+        }                                                                       \
+    } while (0)
+
+void test_fused_preprocess();
+
+void test_kalman_filter_bank();
+
+#endif //TEST_COMMON_HPP
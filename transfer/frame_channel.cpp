@@ -0,0 +1,157 @@
+//
+// Created by JellyfishKnight on 25-7-12.
+//
+#include "frame_channel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+bool VideoFrame::covers(const cv::Rect2f& region) const
+{
+    if (region.empty())
+    {
+        return is_complete();
+    }
+    // 与解码器相同的取整方式：左上向下取整，右下向上取整
+    const int width = image.cols;
+    const int height = image.rows;
+    const int x0 = std::clamp(static_cast<int>(std::floor(region.x * width)), 0, width);
+    const int x1 = std::clamp(static_cast<int>(std::ceil((region.x + region.width) * width)), 0, width);
+    const int y0 = std::clamp(static_cast<int>(std::floor(region.y * height)), 0, height);
+    const int y1 = std::clamp(static_cast<int>(std::ceil((region.y + region.height) * height)), 0, height);
+    const cv::Rect needed(x0, y0, x1 - x0, y1 - y0);
+    return (needed & valid) == needed;
+}
+
+cv::Mat VideoFrame::valid_image() const
+{
+    if (is_complete())
+    {
+        return image;
+    }
+    cv::Mat result = cv::Mat::zeros(image.size(), image.type());
+    const cv::Rect region = valid & cv::Rect(0, 0, image.cols, image.rows);
+    if (!region.empty())
+    {
+        image(region).copyTo(result(region));
+    }
+    return result;
+}
+
+void FrameSignal::notify()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++count_;
+    }
+    cv_.notify_all();
+}
+
+uint64_t FrameSignal::wait_until(uint64_t seen, std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_until(lock, deadline, [this, seen] { return count_ != seen; });
+    return count_;
+}
+
+cv::Mat FramePool::acquire()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty())
+    {
+        return {};
+    }
+    cv::Mat image = std::move(free_.back());
+    free_.pop_back();
+    return image;
+}
+
+std::shared_ptr<VideoFrame> FramePool::make_frame(cv::Mat image)
+{
+    std::weak_ptr<FramePool> weak = weak_from_this();
+    auto* frame = new VideoFrame;
+    frame->image = std::move(image);
+    return std::shared_ptr<VideoFrame>(frame, [weak](VideoFrame* released) {
+        if (auto pool = weak.lock())
+        {
+            pool->recycle(std::move(released->image));
+        }
+        delete released;
+    });
+}
+
+void FramePool::recycle(cv::Mat image)
+{
+    // 读者浅拷贝了像素并仍在使用时不能复用
+    // 引用计数由其他线程原子地增减，必须原子读取（加 0 返回当前值）；
+    // 读到 1 时只剩这一个引用，其他线程已无法再增加它
+    if (image.empty() || !image.u || CV_XADD(&image.u->refcount, 0) != 1)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < capacity_)
+    {
+        free_.push_back(std::move(image));
+    }
+}
+
+uint64_t LatestFrameChannel::publish(cv::Mat image, std::chrono::steady_clock::time_point received_at,
+                                     const cv::Rect& valid, const std::shared_ptr<FramePool>& pool)
+{
+    std::shared_ptr<VideoFrame> frame;
+    if (pool)
+    {
+        frame = pool->make_frame(std::move(image));
+    }
+    else
+    {
+        frame = std::make_shared<VideoFrame>();
+        frame->image = std::move(image);
+    }
+    frame->valid = valid.empty() ? cv::Rect(0, 0, frame->image.cols, frame->image.rows) : valid;
+    frame->seq = next_seq_.fetch_add(1, std::memory_order_relaxed);
+    frame->received_at = received_at;
+    const uint64_t seq = frame->seq;
+    FrameRef previous;
+    std::shared_ptr<FrameSignal> signal;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        previous = std::exchange(latest_, std::move(frame));
+        signal = signal_;
+    }
+    // 旧帧在最后一个读者释放引用时销毁，这里可能是最后一个引用，在锁外释放
+    previous.reset();
+    if (signal)
+    {
+        signal->notify();
+    }
+    return seq;
+}
+
+FrameRef LatestFrameChannel::latest() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latest_;
+}
+
+uint64_t LatestFrameChannel::sequence() const
+{
+    auto frame = latest();
+    return frame ? frame->seq : 0;
+}
+
+void LatestFrameChannel::clear()
+{
+    FrameRef previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        previous = std::exchange(latest_, nullptr);
+    }
+}
+
+void LatestFrameChannel::set_signal(std::shared_ptr<FrameSignal> signal)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(signal_, signal);
+}
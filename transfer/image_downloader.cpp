@@ -15,11 +15,11 @@
  * Licensed under the Apache License, Version 2.0
  */
 #include "image_downloader.hpp"
+#include <deque>
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 #include <QUrl>
-#include <QMutexLocker>
 #include <QTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -29,6 +29,8 @@ ESP32VideoStream::ESP32VideoStream(QObject *parent)
 }
 
 ESP32VideoStream::~ESP32VideoStream() {
+    // 等待正在解码的帧完成，之后解码任务不再访问本对象
+    stream_decoder.close();
     if (isRunning) {
         stop();
     }
@@ -347,20 +349,20 @@ void ESP32VideoStream::stop() {
         webSocket = nullptr;
     }
 
-    // 清空图像队列
-    QMutexLocker locker(&mutex);
-    while (!image_buffer_queue.empty()) {
-        image_buffer_queue.pop();
-    }
+    // 丢弃等待解码的消息和最新帧，读者已持有的帧不受影响
+    stream_decoder.clear();
+    frame_channel.clear();
 }
 
-cv::Mat ESP32VideoStream::getLatestFrame() const
+FrameRef ESP32VideoStream::getLatestFrame() const
 {
-    QMutexLocker locker(&mutex);
-    if (image_buffer_queue.empty()) {
-        return {};
-    }
-    return image_buffer_queue.front().clone();
+    return frame_channel.latest();
+}
+
+void ESP32VideoStream::setDecodeRegion(const cv::Rect2f& region)
+{
+    std::lock_guard<std::mutex> lock(decode_region_mutex);
+    decode_region = region;
 }
 
 // 修改 onConnected 方法
@@ -446,7 +448,7 @@ void ESP32VideoStream::onBinaryMessageReceived(const QByteArray &message)
                 frame_timestamps.back() - frame_timestamps.front()).count();
             float fps = (frame_timestamps.size() - 1) / duration;
 
-            LOG_DEBUG("当前WebSocket帧率: {} FPS", fps);
+            LOG_DEBUG("当前WebSocket帧率: {} FPS，解码跟不上丢弃 {} 帧", fps, stream_decoder.dropped());
             last_fps_log_time = current_time;
         }
 
@@ -456,20 +458,31 @@ void ESP32VideoStream::onBinaryMessageReceived(const QByteArray &message)
             return;
         }
 
-        // 直接使用OpenCV解码数据 - 模仿HTML测试页面的处理方式
-        std::vector<uchar> buffer(message.begin(), message.end());
-        cv::Mat rawFrame = cv::imdecode(buffer, cv::IMREAD_COLOR);
+        // 事件循环里只入队，解码在线程池中进行
+        stream_decoder.submit(message, current_time);
 
-        if (!rawFrame.empty()) {
-            // LOG_DEBUG("成功解码图像，尺寸: " + std::to_string(rawFrame.cols) + "x" + std::to_string(rawFrame.rows));
+    } catch (const std::exception& e) {
+        LOG_ERROR("处理WebSocket消息时出错: {}", e.what());
+    }
+}
 
-            QMutexLocker locker(&mutex);
-            if (image_buffer_queue.empty()) {
-                image_buffer_queue.push(std::move(rawFrame));
-            } else {
-                image_buffer_queue.pop();
-                image_buffer_queue.push(std::move(rawFrame));
-            }
+void ESP32VideoStream::decodeMessage(const QByteArray &message, std::chrono::steady_clock::time_point received_at)
+{
+    try {
+        // 预览不可见时只解码推理用到的区域
+        cv::Rect2f region;
+        if (!full_frame_required) {
+            std::lock_guard<std::mutex> lock(decode_region_mutex);
+            region = decode_region;
+        }
+        // 直接从消息字节解码，缓冲区来自帧池，读者释放旧帧后复用
+        cv::Mat rawFrame = frame_pool->acquire();
+        // 只解码了区域时，区域外是缓冲区的旧内容，有效区域随帧发布
+        cv::Rect decoded;
+        if (decoder.decode(reinterpret_cast<const uchar*>(message.constData()),
+                           static_cast<size_t>(message.size()), rawFrame, region, &decoded)) {
+            // LOG_DEBUG("成功解码图像，尺寸: " + std::to_string(rawFrame.cols) + "x" + std::to_string(rawFrame.rows));
+            frame_channel.publish(std::move(rawFrame), received_at, decoded, frame_pool);
         } else {
             // 如果OpenCV解码失败，尝试Qt的方法
             QImage image;
@@ -478,14 +491,7 @@ void ESP32VideoStream::onBinaryMessageReceived(const QByteArray &message)
                 cv::Mat frame = QImageToCvMat(image);
 
                 if (!frame.empty()) {
-                    QMutexLocker locker(&mutex);
-                    image_not_receive_count = 0;
-                    if (image_buffer_queue.empty()) {
-                        image_buffer_queue.push(std::move(frame));
-                    } else {
-                        image_buffer_queue.pop();
-                        image_buffer_queue.push(std::move(frame));
-                    }
+                    frame_channel.publish(std::move(frame), received_at);
                 }
             } else {
                 // 如果Qt也失败，记录数据头部信息
@@ -502,7 +508,7 @@ void ESP32VideoStream::onBinaryMessageReceived(const QByteArray &message)
         }
 
     } catch (const std::exception& e) {
-        LOG_ERROR("处理WebSocket消息时出错: {}", e.what());
+        LOG_ERROR("解码视频帧时出错: {}", e.what());
     }
 }
 
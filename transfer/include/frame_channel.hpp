@@ -0,0 +1,113 @@
+//
+// Created by JellyfishKnight on 25-7-12.
+//
+
+#ifndef FRAME_CHANNEL_HPP
+#define FRAME_CHANNEL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// 解码完成的一帧，发布后只读，多个读者共享同一份像素数据
+struct VideoFrame
+{
+    cv::Mat image;
+    // 有效像素区域，整帧解码时为整幅图像；只解码了 ROI 时区域外是帧池缓冲区的旧内容，不能使用
+    cv::Rect valid;
+    uint64_t seq = 0;   // 从 1 开始递增，同一序号表示同一帧
+    std::chrono::steady_clock::time_point received_at;
+
+    bool is_complete() const { return valid == cv::Rect(0, 0, image.cols, image.rows); }
+
+    // 归一化区域（与 JpegDecoder::decode 的 region 相同）是否都在有效区域内，区域为空时要求整帧有效
+    bool covers(const cv::Rect2f& region) const;
+
+    // 整帧有效时直接返回共享的 image（只读），否则返回有效区域外清零的副本，供需要整幅图像的预览使用
+    cv::Mat valid_image() const;
+};
+
+// 持有期间帧数据不会被释放或复用，离开作用域自动释放
+using FrameRef = std::shared_ptr<const VideoFrame>;
+
+// 新帧到达通知，可由多个通道共用（如左右眼两路视频流唤醒同一个推理线程）
+// 等待方记住上次看到的计数，计数增加即表示有新帧，通知不会丢失
+class FrameSignal
+{
+public:
+    void notify();
+
+    // 等到计数超过 seen 或到达 deadline，返回当前计数
+    uint64_t wait_until(uint64_t seen, std::chrono::steady_clock::time_point deadline);
+
+    uint64_t wait_for(uint64_t seen, std::chrono::milliseconds timeout)
+    {
+        return wait_until(seen, std::chrono::steady_clock::now() + timeout);
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t count_ = 0;
+};
+
+// 帧缓冲池
+// 帧的最后一个引用释放后像素缓冲区回到池中，下一次解码直接写入，尺寸不变时不再分配内存
+class FramePool : public std::enable_shared_from_this<FramePool>
+{
+public:
+    explicit FramePool(size_t capacity = 4) : capacity_(capacity) {}
+
+    // 取出一个空闲缓冲区，池为空时返回空 Mat，由解码时分配
+    cv::Mat acquire();
+
+    // 包装为帧，帧销毁时缓冲区回到池中；池先于帧销毁时缓冲区直接释放
+    std::shared_ptr<VideoFrame> make_frame(cv::Mat image);
+
+private:
+    void recycle(cv::Mat image);
+
+    std::mutex mutex_;
+    std::vector<cv::Mat> free_;
+    size_t capacity_;
+};
+
+// 只保留最新一帧的通道
+// 写者发布时只交换一个指针，不拷贝像素，也不等待读者处理帧；读者拿到引用后各自使用，互不影响
+// 需要修改图像的读者应写入自己的缓冲区（如 resize 到新的 Mat），不能原地修改共享的帧
+//
+// 指针交换由互斥锁保护，不是无锁实现：std::atomic<std::shared_ptr> 在 libstdc++ 和 MSVC 上同样是内部加锁，
+// 这里直接用互斥锁，行为在各平台一致。锁内只有指针交换或引用计数加一，旧帧在锁外释放（释放时会回到帧池），
+// 每路视频流只有一个写者和一两个读者，争用可以忽略
+class LatestFrameChannel
+{
+public:
+    // 发布新帧并返回分配的序号；valid 为空表示整帧有效；给出 pool 时帧释放后缓冲区回到该池
+    uint64_t publish(cv::Mat image, std::chrono::steady_clock::time_point received_at, const cv::Rect& valid = {},
+                     const std::shared_ptr<FramePool>& pool = nullptr);
+
+    // 最新一帧，没有帧时为空
+    FrameRef latest() const;
+
+    // 最新一帧的序号，没有帧时为 0
+    uint64_t sequence() const;
+
+    // 丢弃当前帧，序号继续递增
+    void clear();
+
+    // 每次发布后通知该信号，为空时不通知
+    void set_signal(std::shared_ptr<FrameSignal> signal);
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const VideoFrame> latest_;
+    std::shared_ptr<FrameSignal> signal_;
+    std::atomic<uint64_t> next_seq_{1};
+};
+
+#endif //FRAME_CHANNEL_HPP
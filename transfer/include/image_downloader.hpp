@@ -4,12 +4,15 @@
 #include <vector>
 #include <thread>
 #include <atomic>
-#include <queue>
+#include <chrono>
+#include <mutex>
 #include <opencv2/core.hpp>
 #include <QWebSocket>
 #include <QObject>
-#include <QMutex>
 #include <QTimer>
+#include "frame_channel.hpp"
+#include "jpeg_decoder.hpp"
+#include "stream_decoder.hpp"
 #include "http_server.hpp"  // 添加这一行
 #include "logger.hpp"
 #include <QDnsLookup>
@@ -34,8 +37,25 @@ public:
     // 停止视频流
     void stop();
 
-    // 获取最新的帧
-    cv::Mat getLatestFrame() const;
+    // 获取最新的帧，不拷贝像素；帧是只读的，需要修改时先写入自己的缓冲区
+    // 设置了解码区域时帧可能只有部分有效，读者按 VideoFrame::valid 检查
+    FrameRef getLatestFrame() const;
+
+    // 设置解码的通道数和最小尺寸，按下游实际使用的分辨率缩小解码；需在 start 之前调用
+    void setDecodeOptions(const JpegDecodeOptions& options) { decoder.set_options(options); }
+
+    // 推理实际使用的源图区域，归一化到 [0, 1]；为空时解码整帧
+    // 不需要整帧且支持区域解码时只解码覆盖该区域的 MCU，区域外的像素不属于当前帧
+    void setDecodeRegion(const cv::Rect2f& region);
+
+    // 预览可见时需要整帧，此时忽略解码区域
+    void setFullFrameRequired(bool required) { full_frame_required = required; }
+
+    // 每发布一帧通知一次，推理线程据此等待新帧
+    void setFrameSignal(std::shared_ptr<FrameSignal> signal) { frame_channel.set_signal(std::move(signal)); }
+
+    // 解码跟不上接收时被新帧替换掉的帧数
+    uint64_t getDroppedFrames() const { return stream_decoder.dropped(); }
 
     // 检查流是否正在运行
     bool isStreaming() const { return isRunning; }
@@ -76,6 +96,8 @@ private slots:
     void checkHeartBeat();
 
 private:
+    // 在解码线程中解码一条消息并发布
+    void decodeMessage(const QByteArray &message, std::chrono::steady_clock::time_point received_at);
     // 将QImage转换为cv::Mat
     cv::Mat QImageToCvMat(const QImage &image) const;
     // 添加以下成员变量
@@ -101,11 +123,22 @@ private:
     std::atomic<bool> isRunning;
     std::string currentStreamUrl;
     QWebSocket* webSocket;
-    mutable QMutex mutex;
-    std::queue<cv::Mat> image_buffer_queue;
+    // 最新一帧，读者共享同一份数据
+    LatestFrameChannel frame_channel;
+    // 直接从消息字节解码到池中的缓冲区
+    JpegDecoder decoder;
+    std::shared_ptr<FramePool> frame_pool = std::make_shared<FramePool>();
+    std::mutex decode_region_mutex;
+    cv::Rect2f decode_region;
+    std::atomic<bool> full_frame_required{true};
     // 已有的成员...
     float battery_percentage = 0.0f;
     int brightness_value = 0;
     int image_not_receive_count = 0;
     QTimer* heartbeatTimer;
+    // 放在最后，先于解码用到的成员析构
+    StreamDecoder stream_decoder{decode_thread_pool(),
+        [this](const QByteArray& message, std::chrono::steady_clock::time_point received_at) {
+            decodeMessage(message, received_at);
+        }};
 };
\ No newline at end of file
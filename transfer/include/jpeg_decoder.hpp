@@ -0,0 +1,63 @@
+//
+// Created by JellyfishKnight on 25-7-12.
+//
+
+#ifndef JPEG_DECODER_HPP
+#define JPEG_DECODER_HPP
+
+#include <cstddef>
+#include <opencv2/core.hpp>
+
+// SOF 段中的图像信息
+struct JpegInfo
+{
+    int width = 0;
+    int height = 0;
+    int components = 0;   // 1 为灰度，3 为彩色
+};
+
+// 只解析到 SOF 段得到尺寸和通道数，不解码图像数据；不是 JPEG 或数据不完整时返回 false
+bool read_jpeg_info(const uchar* data, size_t size, JpegInfo& info);
+
+// 解码输出设置
+struct JpegDecodeOptions
+{
+    // 直接解码为灰度，跳过色度分量的上采样和颜色转换
+    bool grayscale = false;
+    // 下游需要的最小尺寸，在 DCT 域按 1/2、1/4、1/8 缩小解码后宽高仍不小于该尺寸；为空时按原尺寸解码
+    cv::Size min_size;
+};
+
+// 按下游实际需要的分辨率和通道数解码 JPEG
+// 缩小解码由 OpenCV 的 IMREAD_REDUCED_* 完成，libjpeg 在反量化时直接输出缩小后的图像
+// 编译时找到 libjpeg-turbo 则支持只解码指定区域：跳过区域上方的扫描行，横向只解码覆盖区域的 MCU 列
+class JpegDecoder
+{
+public:
+    void set_options(const JpegDecodeOptions& options) { options_ = options; }
+
+    const JpegDecodeOptions& options() const { return options_; }
+
+    // data 为消息字节，不拷贝；dst 的尺寸和类型与本次输出一致时直接写入原缓冲区
+    // region 为归一化到 [0, 1] 的源图区域，为空时解码整帧；dst 始终是整帧尺寸，只有 decoded 内的像素属于本帧
+    bool decode(const uchar* data, size_t size, cv::Mat& dst,
+                const cv::Rect2f& region = cv::Rect2f(), cv::Rect* decoded = nullptr);
+
+    // 最近一次解码的缩小倍数：1、2、4 或 8
+    int last_scale() const { return last_scale_; }
+
+    // 是否支持区域解码，不支持时 decode 总是解码整帧
+    static bool supports_region();
+
+private:
+    // 满足最小尺寸的最大缩小倍数
+    int choose_scale(const JpegInfo& info) const;
+
+    bool decode_region(const uchar* data, size_t size, int scale, const cv::Rect2f& region,
+                       cv::Mat& dst, cv::Rect& decoded) const;
+
+    JpegDecodeOptions options_;
+    int last_scale_ = 1;
+};
+
+#endif //JPEG_DECODER_HPP
@@ -5,10 +5,12 @@
 #ifndef OSC_HPP
 #define OSC_HPP
 
+#include <span>
 #include <string>
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <blendshape_schema.hpp>
 #include "ip/UdpSocket.h"
 #include "logger.hpp"
 
@@ -28,6 +30,9 @@ public:
     // 发送模型输出
     bool sendModelOutput(const std::vector<float>& output, const std::vector<std::string>& blend_shapes);
 
+    // 按 blendshape_schema.hpp 的顺序发送面捕输出，地址使用编译期生成的补齐地址，直接拼装数据包
+    bool sendModelOutput(std::span<const float> output);
+
     // 关闭连接
     void close();
 
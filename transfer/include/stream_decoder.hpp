@@ -0,0 +1,83 @@
+//
+// Created by JellyfishKnight on 25-7-12.
+//
+
+#ifndef STREAM_DECODER_HPP
+#define STREAM_DECODER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <QByteArray>
+#include <thread_pool.hpp>
+
+// 所有视频流共用的解码线程池，线程数不超过设备数
+utils::ThreadPool& decode_thread_pool();
+
+// 单个视频流的解码入口
+// 接收线程只把消息放进槽位后立即返回，解码在线程池中进行
+// 每个流同一时刻最多一帧在解码、一帧在等待：等待中的帧被更新的消息替换时计为丢弃，解码跟不上时不会积压，
+// 同一个流的帧按接收顺序发布
+class StreamDecoder
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using DecodeFunc = std::function<void(const QByteArray& message, Clock::time_point received_at)>;
+
+    StreamDecoder(utils::ThreadPool& pool, DecodeFunc func);
+    ~StreamDecoder();
+
+    StreamDecoder(const StreamDecoder&) = delete;
+    StreamDecoder& operator=(const StreamDecoder&) = delete;
+
+    // QByteArray 隐式共享，这里只增加引用计数
+    void submit(const QByteArray& message, Clock::time_point received_at);
+
+    // 丢弃等待中的帧，不计入丢弃数
+    void clear();
+
+    // 丢弃等待中的帧并等待正在解码的帧完成，之后不再接收消息；所属对象析构前调用
+    void close();
+
+    // 因解码跟不上被替换掉的帧数
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    // 随提交的任务一起销毁：任务运行结束后，或线程池已停止、任务未运行就被丢弃时
+    // 不可拷贝，保证每个任务只复位一次
+    struct TaskGuard
+    {
+        explicit TaskGuard(StreamDecoder* owner) : owner(owner) {}
+        TaskGuard(const TaskGuard&) = delete;
+        TaskGuard& operator=(const TaskGuard&) = delete;
+        ~TaskGuard() { owner->on_task_released(); }
+
+        StreamDecoder* owner;
+    };
+
+    // 在不持有 mutex_ 时调用：线程池丢弃任务时会在 submit 内部同步销毁守卫
+    void schedule();
+
+    void run();
+
+    // 还有等待中的帧且线程池仍在运行时提交新任务，否则复位 scheduled_ 并唤醒 close
+    void on_task_released();
+
+    utils::ThreadPool& pool_;
+    DecodeFunc func_;
+
+    std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    QByteArray pending_;
+    Clock::time_point pending_time_;
+    bool has_pending_ = false;
+    // 已提交到线程池且任务尚未销毁，只由 TaskGuard 复位
+    bool scheduled_ = false;
+    bool closed_ = false;
+    std::atomic<uint64_t> dropped_{0};
+};
+
+#endif //STREAM_DECODER_HPP
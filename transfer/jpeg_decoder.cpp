@@ -0,0 +1,243 @@
+//
+// Created by JellyfishKnight on 25-7-12.
+//
+#include "jpeg_decoder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgcodecs.hpp>
+
+#ifdef PAPERTRACKER_HAS_LIBJPEG_TURBO
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+#endif
+
+namespace
+{
+    int read_u16(const uchar* p)
+    {
+        return (p[0] << 8) | p[1];
+    }
+
+    bool is_sof_marker(uchar marker)
+    {
+        // C4 (DHT)、C8 (JPG)、CC (DAC) 不是 SOF
+        return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+    }
+
+    int imread_flags(bool grayscale, int scale)
+    {
+        switch (scale)
+        {
+        case 2: return grayscale ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2;
+        case 4: return grayscale ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4;
+        case 8: return grayscale ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8;
+        default: return grayscale ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+        }
+    }
+
+#ifdef PAPERTRACKER_HAS_LIBJPEG_TURBO
+    struct ErrorManager
+    {
+        jpeg_error_mgr pub;
+        jmp_buf jump;
+    };
+
+    void on_jpeg_error(j_common_ptr cinfo)
+    {
+        longjmp(reinterpret_cast<ErrorManager*>(cinfo->err)->jump, 1);
+    }
+
+    void on_jpeg_message(j_common_ptr)
+    {
+        // 数据损坏等警告不打印，解码结果由调用方判断
+    }
+#endif
+}
+
+bool read_jpeg_info(const uchar* data, size_t size, JpegInfo& info)
+{
+    if (!data || size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+    {
+        return false;
+    }
+    size_t pos = 2;
+    while (pos + 1 < size)
+    {
+        if (data[pos] != 0xFF)
+        {
+            return false;
+        }
+        // 跳过填充字节
+        while (pos < size && data[pos] == 0xFF)
+        {
+            ++pos;
+        }
+        if (pos >= size)
+        {
+            return false;
+        }
+        const uchar marker = data[pos++];
+        // 没有长度字段的标记
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+        {
+            continue;
+        }
+        // 到达扫描数据或图像结束仍未找到 SOF
+        if (marker == 0xD9 || marker == 0xDA || pos + 2 > size)
+        {
+            return false;
+        }
+        const int length = read_u16(data + pos);
+        if (length < 2 || pos + length > size)
+        {
+            return false;
+        }
+        if (is_sof_marker(marker))
+        {
+            if (length < 8)
+            {
+                return false;
+            }
+            info.height = read_u16(data + pos + 3);
+            info.width = read_u16(data + pos + 5);
+            info.components = data[pos + 7];
+            return info.width > 0 && info.height > 0;
+        }
+        pos += length;
+    }
+    return false;
+}
+
+int JpegDecoder::choose_scale(const JpegInfo& info) const
+{
+    if (options_.min_size.empty())
+    {
+        return 1;
+    }
+    for (int scale : {8, 4, 2})
+    {
+        // libjpeg 缩小后的尺寸向上取整
+        const int width = (info.width + scale - 1) / scale;
+        const int height = (info.height + scale - 1) / scale;
+        if (width >= options_.min_size.width && height >= options_.min_size.height)
+        {
+            return scale;
+        }
+    }
+    return 1;
+}
+
+bool JpegDecoder::supports_region()
+{
+#ifdef PAPERTRACKER_HAS_LIBJPEG_TURBO
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool JpegDecoder::decode(const uchar* data, size_t size, cv::Mat& dst,
+                         const cv::Rect2f& region, cv::Rect* decoded)
+{
+    JpegInfo info;
+    const bool is_jpeg = read_jpeg_info(data, size, info);
+    // 头部解析失败时仍交给 OpenCV，按原尺寸解码
+    const int scale = is_jpeg ? choose_scale(info) : 1;
+
+    cv::Rect decoded_rect;
+    if (is_jpeg && !region.empty() && supports_region() &&
+        decode_region(data, size, scale, region, dst, decoded_rect))
+    {
+        last_scale_ = scale;
+        if (decoded)
+        {
+            *decoded = decoded_rect;
+        }
+        return true;
+    }
+
+    const cv::Mat encoded(1, static_cast<int>(size), CV_8UC1, const_cast<uchar*>(data));
+    cv::imdecode(encoded, imread_flags(options_.grayscale, scale), &dst);
+    if (dst.empty())
+    {
+        return false;
+    }
+    last_scale_ = scale;
+    if (decoded)
+    {
+        *decoded = cv::Rect(0, 0, dst.cols, dst.rows);
+    }
+    return true;
+}
+
+#ifdef PAPERTRACKER_HAS_LIBJPEG_TURBO
+bool JpegDecoder::decode_region(const uchar* data, size_t size, int scale, const cv::Rect2f& region,
+                                cv::Mat& dst, cv::Rect& decoded) const
+{
+    // longjmp 会跳过析构，setjmp 之后不创建需要析构的局部对象
+    jpeg_decompress_struct cinfo;
+    ErrorManager error;
+    cinfo.err = jpeg_std_error(&error.pub);
+    error.pub.error_exit = on_jpeg_error;
+    error.pub.output_message = on_jpeg_message;
+    if (setjmp(error.jump))
+    {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, static_cast<unsigned long>(size));
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK)
+    {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    const int channels = options_.grayscale ? 1 : 3;
+    cinfo.out_color_space = options_.grayscale ? JCS_GRAYSCALE : JCS_EXT_BGR;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = static_cast<unsigned int>(scale);
+    jpeg_start_decompress(&cinfo);
+
+    const int width = static_cast<int>(cinfo.output_width);
+    const int height = static_cast<int>(cinfo.output_height);
+    const int x0 = std::clamp(static_cast<int>(std::floor(region.x * width)), 0, width);
+    const int x1 = std::clamp(static_cast<int>(std::ceil((region.x + region.width) * width)), 0, width);
+    const int y0 = std::clamp(static_cast<int>(std::floor(region.y * height)), 0, height);
+    const int y1 = std::clamp(static_cast<int>(std::ceil((region.y + region.height) * height)), 0, height);
+    if (x1 <= x0 || y1 <= y0)
+    {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    // 池中的缓冲区尺寸相同时直接复用，区域外保留旧内容
+    dst.create(height, width, channels == 1 ? CV_8UC1 : CV_8UC3);
+
+    // 起点对齐到 MCU 边界，宽度相应扩大
+    // 色度上采样在裁剪边缘缺少相邻像素，边缘一列与整帧解码不同，两侧各多解一列并排除在结果之外
+    JDIMENSION x_offset = static_cast<JDIMENSION>(std::max(x0 - 1, 0));
+    JDIMENSION crop_width = static_cast<JDIMENSION>(std::min(x1 + 1, width)) - x_offset;
+    jpeg_crop_scanline(&cinfo, &x_offset, &crop_width);
+    if (y0 > 0)
+    {
+        jpeg_skip_scanlines(&cinfo, static_cast<JDIMENSION>(y0));
+    }
+    while (cinfo.output_scanline < static_cast<JDIMENSION>(y1))
+    {
+        JSAMPROW row = dst.ptr<uchar>(static_cast<int>(cinfo.output_scanline)) + x_offset * channels;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    // 区域下方的扫描行不再解码
+    jpeg_destroy_decompress(&cinfo);
+
+    const int left = static_cast<int>(x_offset) + (x_offset > 0 ? 1 : 0);
+    const int right = static_cast<int>(x_offset + crop_width) - (static_cast<int>(x_offset + crop_width) < width ? 1 : 0);
+    decoded = cv::Rect(left, y0, right - left, y1 - y0);
+    return true;
+}
+#else
+bool JpegDecoder::decode_region(const uchar*, size_t, int, const cv::Rect2f&, cv::Mat&, cv::Rect&) const
+{
+    return false;
+}
+#endif
@@ -32,7 +32,10 @@
 #include <QMessageBox>
 
 #include "osc.hpp"
+#include <bit>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
 // 引入oscpack库
@@ -113,6 +116,60 @@ bool OscManager::sendModelOutput(const std::vector<float>& output, const std::ve
     }
 }
 
+bool OscManager::sendModelOutput(std::span<const float> output) {
+    if (!socket_) {
+        LOG_ERROR("OSC socket未初始化");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    try {
+        float max_clip_value = std::powf(10, std::floor(std::log10(multiplier_)));
+        // 类型标签 ",f" 补齐到 4 字节
+        constexpr char type_tag[4] = {',', 'f', '\0', '\0'};
+        char buffer[OUTPUT_BUFFER_SIZE];
+
+        for (size_t i = 0; i < output.size() && i < kBlendShapeCount; ++i) {
+            const BlendShapeInfo& info = kBlendShapeSchema[i];
+            size_t size = 0;
+            if (location_prefix_.empty()) {
+                std::string_view address = info.osc_address.padded();
+                std::memcpy(buffer, address.data(), address.size());
+                size = address.size();
+            } else {
+                // 有前缀时在运行时拼接并补齐
+                std::string address = location_prefix_ + "/" + std::string(info.name);
+                if (address.size() + 12 > OUTPUT_BUFFER_SIZE) {
+                    LOG_ERROR("OSC地址过长: {}", address);
+                    return false;
+                }
+                std::memcpy(buffer, address.data(), address.size());
+                size_t padded = (address.size() / 4 + 1) * 4;
+                std::memset(buffer + address.size(), 0, padded - address.size());
+                size = padded;
+            }
+            std::memcpy(buffer + size, type_tag, sizeof(type_tag));
+            size += sizeof(type_tag);
+
+            // 参数按大端序写入
+            float value = std::min(output[i] * multiplier_, max_clip_value);
+            uint32_t bits = std::bit_cast<uint32_t>(value);
+            buffer[size++] = static_cast<char>(bits >> 24);
+            buffer[size++] = static_cast<char>(bits >> 16);
+            buffer[size++] = static_cast<char>(bits >> 8);
+            buffer[size++] = static_cast<char>(bits);
+
+            socket_->Send(buffer, static_cast<std::size_t>(size));
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("发送OSC消息错误: {}", e.what());
+        return false;
+    }
+}
+
 void OscManager::close() {
     socket_.reset();
 }
@@ -0,0 +1,117 @@
+//
+// Created by JellyfishKnight on 25-7-12.
+//
+#include "stream_decoder.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+utils::ThreadPool& decode_thread_pool()
+{
+    // 面部加左右眼最多三路视频流，再多的线程用不上
+    static utils::ThreadPool pool(std::clamp(std::thread::hardware_concurrency() / 2, 1u, 3u));
+    return pool;
+}
+
+StreamDecoder::StreamDecoder(utils::ThreadPool& pool, DecodeFunc func)
+    : pool_(pool), func_(std::move(func))
+{
+}
+
+StreamDecoder::~StreamDecoder()
+{
+    close();
+}
+
+void StreamDecoder::submit(const QByteArray& message, Clock::time_point received_at)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_)
+        {
+            return;
+        }
+        if (has_pending_)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pending_ = message;
+        pending_time_ = received_at;
+        has_pending_ = true;
+        // 已有任务在处理这个流时由它接着解码，不再提交新任务
+        if (scheduled_ || !pool_.is_running())
+        {
+            return;
+        }
+        scheduled_ = true;
+    }
+    schedule();
+}
+
+void StreamDecoder::schedule()
+{
+    // 线程池停止后 submit 直接丢弃任务，守卫随之销毁并复位 scheduled_，close 不会一直等待
+    pool_.submit([this, guard = std::make_shared<TaskGuard>(this)] { run(); });
+}
+
+void StreamDecoder::on_task_released()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // run 退出后、守卫销毁前到达的帧由新任务处理
+        if (!has_pending_ || closed_ || !pool_.is_running())
+        {
+            scheduled_ = false;
+            idle_cv_.notify_all();
+            return;
+        }
+    }
+    schedule();
+}
+
+void StreamDecoder::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+    has_pending_ = false;
+}
+
+void StreamDecoder::close()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+    pending_.clear();
+    has_pending_ = false;
+    idle_cv_.wait(lock, [this] { return !scheduled_; });
+}
+
+void StreamDecoder::run()
+{
+    while (true)
+    {
+        QByteArray message;
+        Clock::time_point received_at;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // scheduled_ 由任务销毁时的守卫复位
+            if (!has_pending_ || closed_)
+            {
+                return;
+            }
+            message = std::move(pending_);
+            pending_ = QByteArray();
+            received_at = pending_time_;
+            has_pending_ = false;
+        }
+        // 异常不能带出循环，解码出错不影响后续帧
+        try
+        {
+            func_(message, received_at);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("解码视频帧出错: {}", e.what());
+        }
+    }
+}
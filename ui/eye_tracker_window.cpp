@@ -13,6 +13,8 @@
 #include <QInputDialog>
 #include "tools.hpp"
 #include <algorithm>
+
+#define EYE_MODEL_PATH "./model/eye_model.onnx"
 // 生成测试数据的函数
 struct TestEyeData {
     float eyeLidLeft;
@@ -254,12 +256,13 @@ PaperEyeTrackerWindow::PaperEyeTrackerWindow(QWidget* parent) :
 
     set_config();
 
-    LOG_INFO("正在加载模型...")
-        for (int i = 0; i < EYE_NUM; i++) {
-            inference_[i] = std::make_shared<EyeInference>();
-            inference_[i]->load_model("");
-        }
-    LOG_INFO("模型加载完成");
+    // 模型在推理线程中加载，见 load_eye_models
+    batch_inference_ = std::make_shared<EyeInference>(EYE_NUM);
+    batch_inference_->set_output_filter(config.output_filter);
+    batch_inference_->set_change_gate(config.change_gate);
+    batch_inference_->set_cascade(config.cascade);
+    batch_inference_->set_uint8_input(config.uint8_input);
+    batch_inference_->set_execution_provider(config.execution_provider);
     LOG_INFO("正在初始化OSC...");
     if (osc_manager->init("127.0.0.1", 8889)) {
         osc_manager->setLocationPrefix("");
@@ -297,6 +300,9 @@ PaperEyeTrackerWindow::PaperEyeTrackerWindow(QWidget* parent) :
     // 初始化串口和wifi
     for (int i = 0; i < EYE_NUM; i++) {
         image_stream[i] = std::make_shared<ESP32VideoStream>();
+        // 推理只用灰度，解码时直接输出不小于 280x280 的灰度图
+        image_stream[i]->setDecodeOptions({true, cv::Size(280, 280)});
+        image_stream[i]->setFrameSignal(frame_signal);
     }
     serial_port_ = std::make_shared<SerialPortManager>();
 
@@ -441,6 +447,7 @@ PaperEyeTrackerWindow::PaperEyeTrackerWindow(QWidget* parent) :
     connect(ui.LeftRotateBar, &QScrollBar::valueChanged, this, &PaperEyeTrackerWindow::onLeftRotateAngleChanged);
     connect(ui.RightRotateBar, &QScrollBar::valueChanged, this, &PaperEyeTrackerWindow::onRightRotateAngleChanged);
     create_sub_thread();
+    setup_model_watcher();
     // 创建自动保存配置的定时器
     auto_save_timer = new QTimer(this);
     connect(auto_save_timer, &QTimer::timeout, this, [this]() {
@@ -496,6 +503,290 @@ void PaperEyeTrackerWindow::setVideoImage(int version, const cv::Mat& image) {
         }, Qt::QueuedConnection);
 }
 
+bool PaperEyeTrackerWindow::wait_for_frames(uint64_t& signal_seen, const uint64_t (&last_seq)[EYE_NUM],
+                                            std::chrono::steady_clock::time_point& last_infer_time, bool gather_all) {
+    auto has_new_frame = [this, &last_seq](int version) {
+        FrameRef video_frame = getVideoImage(version);
+        return video_frame && video_frame->seq != last_seq[version];
+    };
+    // 超时后返回，由调用方检查退出和模型重载
+    signal_seen = frame_signal->wait_for(signal_seen, std::chrono::milliseconds(100));
+    if (!has_new_frame(LEFT_TAG) && !has_new_frame(RIGHT_TAG)) {
+        return false;
+    }
+    // max_fps 只是上限，间隔内到达的帧在等满间隔后一起处理
+    const auto min_interval = std::chrono::microseconds(1000000 / max(1, get_max_fps()));
+    if (std::chrono::steady_clock::now() < last_infer_time + min_interval) {
+        std::this_thread::sleep_until(last_infer_time + min_interval);
+    }
+    if (gather_all) {
+        // 另一只眼在推流但还没有新帧时稍等，两路不同步时避免一对帧拆成两次推理
+        const auto deadline = std::chrono::steady_clock::now() + min_interval / 2;
+        auto waiting_other = [this, &has_new_frame]() {
+            for (int version = 0; version < EYE_NUM; version++) {
+                if (image_stream[version]->isStreaming() && !has_new_frame(version)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        while (waiting_other() && std::chrono::steady_clock::now() < deadline) {
+            signal_seen = frame_signal->wait_until(signal_seen, deadline);
+        }
+    }
+    last_infer_time = std::chrono::steady_clock::now();
+    return true;
+}
+
+cv::Mat PaperEyeTrackerWindow::prepare_inference_frame(int version, uint64_t& last_seq, cv::Rect& roi,
+                                                       std::chrono::steady_clock::time_point& received_at) {
+    FrameRef video_frame = getVideoImage(version);
+    // 没有新帧时不重复推理
+    if (!video_frame || video_frame->image.empty() || video_frame->seq == last_seq) {
+        return {};
+    }
+    last_seq = video_frame->seq;
+    received_at = video_frame->received_at;
+    auto rotate_angle = getRotateAngle(version);
+    auto roi_rect = getRoiRect(version);
+    const cv::Size frame_size(280, 280);
+    const cv::Rect2f source_region = roi_rect.is_roi_end
+        ? roi_source_region(roi_rect.rect, frame_size, rotate_angle) : cv::Rect2f();
+    // 下一帧只解码 ROI 覆盖的源图区域，预览可见时仍解码整帧
+    image_stream[version]->setDecodeRegion(source_region);
+    // 按旧 ROI 只解码了部分区域的帧不一定覆盖当前 ROI，区域外是旧内容，跳过这一帧
+    if (!video_frame->covers(source_region)) {
+        return {};
+    }
+    // 共享帧只读，缩放结果写入新的缓冲区，之后的旋转、裁剪和翻转都在该缓冲区上进行
+    cv::Mat frame;
+    cv::resize(video_frame->image, frame, frame_size, cv::INTER_NEAREST);
+    int y = frame.rows / 2;
+    int x = frame.cols / 2;
+    auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(x, y), rotate_angle, 1);
+    cv::warpAffine(frame, frame, rotate_matrix, frame.size(), cv::INTER_NEAREST);
+    cv::Mat infer_frame = frame;
+    roi = roi_rect.rect;
+    if (!roi_rect.rect.empty() && roi_rect.is_roi_end) {
+        infer_frame = infer_frame(roi_rect.rect);
+    }
+    if (version == LEFT_TAG) {
+        // 水平翻转图像（沿y轴对称）
+        cv::flip(infer_frame, infer_frame, 1);  // 参数1表示水平翻转
+    }
+    return infer_frame;
+}
+
+void PaperEyeTrackerWindow::process_eye_output(int version, std::vector<float>& temp, const cv::Rect& roi) {
+    if (version == LEFT_TAG) {
+        // 对每个坐标点进行处理
+        for (int j = 0; j < temp.size(); j += 2) {
+            // 只调整x坐标 (水平翻转)
+            temp[j] = 1.0f - temp[j];  // 图像宽度减去x坐标值
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock_guard(outputs_mutex[version]);
+        outputs[version] = temp;
+        for (int j = 0; j < EYE_OUTPUT_SIZE; j += 2) {
+            outputs[version][j] = outputs[version][j] * roi.width + roi.x;
+            outputs[version][j + 1] = outputs[version][j + 1] * roi.height + roi.y;
+        }
+    }
+    // 后处理逻辑
+    double dist_1 = cv::norm(outputs[version][1] - outputs[version][3]);
+    double dist_2 = cv::norm(outputs[version][2] - outputs[version][4]);
+    double dist = (dist_1 + dist_2) / 2;
+    {
+        std::lock_guard<std::mutex> lock_guard(results_mutex[version]);
+
+        // 原始眼睛开合度值，不再使用百分位计算
+        eye_open[version] = dist;
+
+        // 处理瞳孔位置
+        pupil[version].x = outputs[version][EYE_OUTPUT_SIZE - 2];
+        pupil[version].y = outputs[version][EYE_OUTPUT_SIZE - 1];
+
+        // 记录校准数据
+        if (is_calibrating) {
+            // 只更新位置校准数据
+            eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
+            eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
+            eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
+            eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
+        }
+
+
+        // 同时更新坐标校准数据，使用pupil[version]而不是pupil_point
+        eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
+        eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
+        eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
+        eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
+
+        // 如果是首个校准样本，设置中心点
+        if (open_list[version].size() == 1) {
+            eye_calib_data[version].calib_XOFF = pupil[version].x;
+            eye_calib_data[version].calib_YOFF = pupil[version].y;
+        }
+
+        // if (open_list[version].size() > CALIBRATION_SAMPLES) {
+        //     if (is_calibrating) {
+        //         calibrated[version] = true;
+        //         eye_calib_data[version].has_calibration = true;
+        //         LOG_INFO("眼睛{}校准完成：已收集足够样本数据 ({} 个样本点)",
+        //                 version == LEFT_TAG ? "左" : "右",
+        //                 open_list[version].size());
+        //         is_calibrating = false; // 结束校准状态
+        //     }
+        // }
+    }
+
+    pupil[version].x = outputs[version][EYE_OUTPUT_SIZE - 2];
+    pupil[version].y = outputs[version][EYE_OUTPUT_SIZE - 1];
+
+    if (is_calibrating) {
+        // 对当前处理的眼睛进行校准数据收集，各眼睛的数据由 results_mutex 分别保护
+        std::lock_guard<std::mutex> lock(results_mutex[version]);
+
+        // 只在有效瞳孔位置时更新校准数据
+        if (pupil[version].x > 0 && pupil[version].y > 0) {
+            // 更新坐标范围
+            eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
+            eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
+            eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
+            eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
+
+            // 如果是首个校准样本，设置中心点
+            if (open_list[version].empty()) {
+                eye_calib_data[version].calib_XOFF = pupil[version].x;
+                eye_calib_data[version].calib_YOFF = pupil[version].y;
+            }
+        }
+    }
+}
+
+void PaperEyeTrackerWindow::load_eye_models() {
+    LOG_INFO("正在加载模型...");
+    // 优先使用批量模式，左右眼共用一个会话一次推理
+    batch_inference_->load_model(EYE_MODEL_PATH);
+    if (batch_inference_->batch_size() != EYE_NUM) {
+        LOG_INFO("眼睛模型不支持批量推理，依次推理左右眼");
+        batch_inference_.reset();
+        for (int i = 0; i < EYE_NUM; i++) {
+            inference_[i] = std::make_shared<EyeInference>();
+            inference_[i]->set_output_filter(config.output_filter);
+            inference_[i]->set_change_gate(config.change_gate);
+            inference_[i]->set_cascade(config.cascade);
+            inference_[i]->set_uint8_input(config.uint8_input);
+            inference_[i]->set_execution_provider(config.execution_provider);
+            inference_[i]->load_model(EYE_MODEL_PATH);
+        }
+    }
+}
+
+void PaperEyeTrackerWindow::batch_inference_loop() {
+    // 批量模式：收集左右眼的最新帧，一次推理完成双眼
+    auto last_time = std::chrono::high_resolution_clock::now();
+    std::vector<cv::Mat> infer_frames(EYE_NUM);
+    cv::Rect rois[EYE_NUM];
+    std::chrono::steady_clock::time_point frame_times[EYE_NUM];
+    std::vector<float> temps[EYE_NUM];
+    uint64_t signal_seen = 0;
+    uint64_t last_seq[EYE_NUM] = {0, 0};
+    std::chrono::steady_clock::time_point last_infer_time;
+    while (is_running()) {
+        if (model_reload_requested.exchange(false)) {
+            batch_inference_->reload_model_async(EYE_MODEL_PATH);
+        }
+        // 模型未就绪时不进行推理
+        if (!batch_inference_->is_ready()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            last_time = std::chrono::high_resolution_clock::now();
+            continue;
+        }
+        // 等待新帧到达，每帧只推理一次
+        if (!wait_for_frames(signal_seen, last_seq, last_infer_time, true)) {
+            continue;
+        }
+        auto start_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(start_time - last_time);
+        last_time = start_time;
+        // 设置时间序列
+        batch_inference_->set_dt(duration.count() / 1000.0);
+
+        bool has_frame = false;
+        for (int version = 0; version < EYE_NUM; version++) {
+            infer_frames[version] = prepare_inference_frame(version, last_seq[version], rois[version], frame_times[version]);
+            has_frame = has_frame || !infer_frames[version].empty();
+        }
+        // 推理处理
+        if (has_frame) {
+            batch_inference_->inference_batch(infer_frames);
+            for (int version = 0; version < EYE_NUM; version++) {
+                if (infer_frames[version].empty()) {
+                    continue;
+                }
+                batch_inference_->set_pipeline_latency(
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_times[version]).count());
+                auto output = batch_inference_->get_output(version);
+                if (!output.empty()) {
+                    temps[version].assign(output.begin(), output.end());
+                    process_eye_output(version, temps[version], rois[version]);
+                }
+            }
+        }
+    }
+}
+
+void PaperEyeTrackerWindow::single_inference_loop() {
+    // 单眼模式：每只眼睛独立的推理实例，依次推理
+    auto last_time = std::chrono::high_resolution_clock::now();
+    std::vector<float> temps[EYE_NUM];
+    uint64_t signal_seen = 0;
+    uint64_t last_seq[EYE_NUM] = {0, 0};
+    std::chrono::steady_clock::time_point last_infer_time;
+    while (is_running()) {
+        if (model_reload_requested.exchange(false)) {
+            for (int version = 0; version < EYE_NUM; version++) {
+                inference_[version]->reload_model_async(EYE_MODEL_PATH);
+            }
+        }
+        // 模型未就绪时不进行推理
+        if (!inference_[LEFT_TAG]->is_ready() || !inference_[RIGHT_TAG]->is_ready()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            last_time = std::chrono::high_resolution_clock::now();
+            continue;
+        }
+        // 等待新帧到达，每帧只推理一次；左右眼各自推理，不必等齐
+        if (!wait_for_frames(signal_seen, last_seq, last_infer_time, false)) {
+            continue;
+        }
+        auto start_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(start_time - last_time);
+        last_time = start_time;
+
+        for (int version = 0; version < EYE_NUM; version++) {
+            // 设置时间序列
+            inference_[version]->set_dt(duration.count() / 1000.0);
+
+            cv::Rect roi;
+            std::chrono::steady_clock::time_point frame_time;
+            auto infer_frame = prepare_inference_frame(version, last_seq[version], roi, frame_time);
+            // 推理处理
+            if (!infer_frame.empty()) {
+                inference_[version]->inference(infer_frame);
+                inference_[version]->set_pipeline_latency(
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_time).count());
+                auto output = inference_[version]->get_output();
+                if (!output.empty()) {
+                    temps[version].assign(output.begin(), output.end());
+                    process_eye_output(version, temps[version], roi);
+                }
+            }
+        }
+    }
+}
+
 void PaperEyeTrackerWindow::create_sub_thread() {
     for (int i = 0; i < EYE_NUM; i++) {
         update_ui_thread[i] = std::thread([this, version = i]() {
@@ -521,11 +812,18 @@ void PaperEyeTrackerWindow::create_sub_thread() {
                     fps_total += fps;
                     fps_count += 1;
                     fps = fps_total / fps_count;
-                    cv::Mat frame = getVideoImage(version);
+                    FrameRef video_frame = getVideoImage(version);
                     // draw rect on frame
                     cv::Mat show_image;
-                    if (!frame.empty()) {
-                        cv::resize(frame, frame, cv::Size(ui.LeftEyeImage->size().width(), ui.LeftEyeImage->size().height()), cv::INTER_NEAREST);
+                    if (video_frame && !video_frame->image.empty()) {
+                        // 共享帧只读，缩放到自己的缓冲区后再绘制
+                        cv::Mat frame;
+                        // 预览刚显示时的帧可能仍只解码了 ROI，区域外清零后再显示
+                        cv::resize(video_frame->valid_image(), frame, cv::Size(ui.LeftEyeImage->size().width(), ui.LeftEyeImage->size().height()), cv::INTER_NEAREST);
+                        // 灰度帧缩放后再转为三通道，预览按 RGB888 显示且需要彩色标注
+                        if (frame.channels() == 1) {
+                            cv::cvtColor(frame, frame, cv::COLOR_GRAY2BGR);
+                        }
                         {
                             // 添加旋转处理
                             auto rotate_angle = getRotateAngle(version);
@@ -579,149 +877,18 @@ void PaperEyeTrackerWindow::create_sub_thread() {
                 std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
             }
             });
-
-        inference_thread[i] = std::thread([this, version = i]() {
-            auto last_time = std::chrono::high_resolution_clock::now();
-            double fps_total = 0;
-            double fps_count = 0;
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            while (is_running()) {
-                if (fps_total > 1000) {
-                    fps_count = 0;
-                    fps_total = 0;
-                }
-                // calculate fps
-                auto start = std::chrono::high_resolution_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(start - last_time);
-                last_time = start;
-                auto fps = 1000.0 / static_cast<double>(duration.count());
-                fps_total += fps;
-                fps_count += 1;
-                fps = fps_total / fps_count;
-                // LOG_DEBUG("模型FPS： {}", fps);
-
-                auto start_time = std::chrono::high_resolution_clock::now();
-                // 设置时间序列
-                inference_[version]->set_dt(duration.count() / 1000.0);
-
-                auto frame = getVideoImage(version);
-                // 推理处理
-                if (!frame.empty()) {
-                    auto rotate_angle = getRotateAngle(version);
-                    cv::resize(frame, frame, cv::Size(280, 280), cv::INTER_NEAREST);
-                    int y = frame.rows / 2;
-                    int x = frame.cols / 2;
-                    auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(x, y), rotate_angle, 1);
-                    cv::warpAffine(frame, frame, rotate_matrix, frame.size(), cv::INTER_NEAREST);
-                    cv::Mat infer_frame;
-                    infer_frame = frame.clone();
-                    auto roi_rect = getRoiRect(version);
-                    if (!roi_rect.rect.empty() && roi_rect.is_roi_end) {
-                        infer_frame = infer_frame(roi_rect.rect);
-                    }
-                    if (version == LEFT_TAG) {
-                    // 水平翻转图像（沿y轴对称）
-                    cv::flip(infer_frame, infer_frame, 1);  // 参数1表示水平翻转
-                    }
-                    inference_[version]->inference(infer_frame);
-                    auto temp = inference_[version]->get_output();
-                    if (temp.empty()) {
-                        continue;
-                    }
-                    if (version == LEFT_TAG) {
-                        // 对每个坐标点进行处理
-                        for (int j = 0; j < temp.size(); j += 2) {
-                            // 只调整x坐标 (水平翻转)
-                            temp[j] = 1.0f - temp[j];  // 图像宽度减去x坐标值
-                        }
-                    }
-                    {
-                        std::lock_guard<std::mutex> lock_guard(outputs_mutex[version]);
-                        outputs[version] = temp;
-                        for (int j = 0; j < EYE_OUTPUT_SIZE; j += 2) {
-                            outputs[version][j] = outputs[version][j] * roi_rect.rect.width + roi_rect.rect.x;
-                            outputs[version][j + 1] = outputs[version][j + 1] * roi_rect.rect.height + roi_rect.rect.y;
-                        }
-                    }
-                    // 后处理逻辑
-                    double dist_1 = cv::norm(outputs[version][1] - outputs[version][3]);
-                    double dist_2 = cv::norm(outputs[version][2] - outputs[version][4]);
-                    double dist = (dist_1 + dist_2) / 2;
-                    {
-                    std::lock_guard<std::mutex> lock_guard(results_mutex[version]);
-
-                        // 原始眼睛开合度值，不再使用百分位计算
-                        eye_open[version] = dist;
-
-                        // 处理瞳孔位置
-                        pupil[version].x = outputs[version][EYE_OUTPUT_SIZE - 2];
-                        pupil[version].y = outputs[version][EYE_OUTPUT_SIZE - 1];
-
-                        // 记录校准数据
-                        if (is_calibrating) {
-                            // 只更新位置校准数据
-                            eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
-                            eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
-                            eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
-                            eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
-                        }
-
-
-                    // 同时更新坐标校准数据，使用pupil[version]而不是pupil_point
-                    eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
-                    eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
-                    eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
-                    eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
-
-                    // 如果是首个校准样本，设置中心点
-                    if (open_list[version].size() == 1) {
-                        eye_calib_data[version].calib_XOFF = pupil[version].x;
-                        eye_calib_data[version].calib_YOFF = pupil[version].y;
-                    }
-
-                        // if (open_list[version].size() > CALIBRATION_SAMPLES) {
-                        //     if (is_calibrating) {
-                        //         calibrated[version] = true;
-                        //         eye_calib_data[version].has_calibration = true;
-                        //         LOG_INFO("眼睛{}校准完成：已收集足够样本数据 ({} 个样本点)",
-                        //                 version == LEFT_TAG ? "左" : "右",
-                        //                 open_list[version].size());
-                        //         is_calibrating = false; // 结束校准状态
-                        //     }
-                        // }
-                }
-
-                        pupil[version].x = outputs[version][EYE_OUTPUT_SIZE - 2];
-                        pupil[version].y = outputs[version][EYE_OUTPUT_SIZE - 1];
-
-                    if (is_calibrating) {
-                    // 对当前处理的眼睛进行校准数据收集，由于左右眼是两个不同的线程，这里不会有冲突
-                    std::lock_guard<std::mutex> lock(results_mutex[version]);
-
-                    // 只在有效瞳孔位置时更新校准数据
-                    if (pupil[version].x > 0 && pupil[version].y > 0) {
-                        // 更新坐标范围
-                        eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
-                        eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
-                        eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
-                        eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
-
-                        // 如果是首个校准样本，设置中心点
-                        if (open_list[version].empty()) {
-                            eye_calib_data[version].calib_XOFF = pupil[version].x;
-                            eye_calib_data[version].calib_YOFF = pupil[version].y;
-                        }
-                    }
-                }
-                }
-                auto end_time = std::chrono::high_resolution_clock::now();
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-                int delay_ms = max(0, static_cast<int>(1000.0 / get_max_fps() - elapsed));
-                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-            }
-            });
     }
 
+    // 在推理线程中加载模型，避免打开窗口时界面卡顿
+    inference_thread[0] = std::thread([this]() {
+        load_eye_models();
+        if (batch_inference_) {
+            batch_inference_loop();
+        } else {
+            single_inference_loop();
+        }
+    });
+
    osc_send_thread = std::thread([this] ()
 {
     int debug_counter = 0;
@@ -1655,8 +1822,35 @@ void PaperEyeTrackerWindow::updateSerialLabel(int version) const {
     }
 }
 
-cv::Mat PaperEyeTrackerWindow::getVideoImage(int version) const {
-    return std::move(image_stream[version]->getLatestFrame());
+void PaperEyeTrackerWindow::showEvent(QShowEvent* event) {
+    QWidget::showEvent(event);
+    updatePreviewVisibility();
+}
+
+void PaperEyeTrackerWindow::hideEvent(QHideEvent* event) {
+    QWidget::hideEvent(event);
+    updatePreviewVisibility();
+}
+
+void PaperEyeTrackerWindow::changeEvent(QEvent* event) {
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange) {
+        updatePreviewVisibility();
+    }
+}
+
+void PaperEyeTrackerWindow::updatePreviewVisibility() {
+    // 窗口隐藏或最小化时没有预览，解码只需覆盖 ROI
+    const bool visible = isVisible() && !isMinimized();
+    for (int i = 0; i < EYE_NUM; i++) {
+        if (image_stream[i]) {
+            image_stream[i]->setFullFrameRequired(visible);
+        }
+    }
+}
+
+FrameRef PaperEyeTrackerWindow::getVideoImage(int version) const {
+    return image_stream[version]->getLatestFrame();
 }
 
 void PaperEyeTrackerWindow::setSerialStatusLabel(const QString& text) const {
@@ -1679,6 +1873,12 @@ PaperEyeTrackerConfig PaperEyeTrackerWindow::generate_config() const {
     res_config.left_brightness = brightness[LEFT_TAG];
     res_config.right_brightness = brightness[RIGHT_TAG];
     res_config.energy_mode = ui.EnergyModelBox->currentIndex();
+    // 滤波设置目前只能在配置文件中修改，原样保存
+    res_config.output_filter = config.output_filter;
+    res_config.change_gate = config.change_gate;
+    res_config.cascade = config.cascade;
+    res_config.uint8_input = config.uint8_input;
+    res_config.execution_provider = config.execution_provider;
     res_config.left_roi = roi_rect[LEFT_TAG];
     res_config.right_roi = roi_rect[RIGHT_TAG];
 
@@ -2213,3 +2413,31 @@ void PaperEyeTrackerWindow::onRightEyeValueDecrease() {
     eye_fully_closed[RIGHT_TAG] = max(5.0, eye_fully_closed[RIGHT_TAG] - 1.0); // 减少闭合值，但不低于5
     LOG_INFO("右眼闭合值减少到: {:.3f}", eye_fully_closed[RIGHT_TAG]);
 }
+
+void PaperEyeTrackerWindow::reload_model()
+{
+    // 由推理线程发起后台加载，推理实例只在推理线程中访问
+    model_reload_requested = true;
+}
+
+void PaperEyeTrackerWindow::setup_model_watcher()
+{
+    model_watcher = new QFileSystemWatcher(this);
+    model_watcher->addPath(EYE_MODEL_PATH);
+    // 文件写入可能分多次完成，最后一次变化一秒后再加载
+    model_reload_timer = new QTimer(this);
+    model_reload_timer->setSingleShot(true);
+    connect(model_watcher, &QFileSystemWatcher::fileChanged, this, [this](const QString&) {
+        model_reload_timer->start(1000);
+    });
+    connect(model_reload_timer, &QTimer::timeout, this, [this]() {
+        // 替换文件后监视会失效，需要重新添加
+        if (!model_watcher->files().contains(EYE_MODEL_PATH)) {
+            model_watcher->addPath(EYE_MODEL_PATH);
+        }
+        if (QFileInfo::exists(EYE_MODEL_PATH)) {
+            LOG_INFO("检测到模型文件更新，正在重新加载");
+            reload_model();
+        }
+    });
+}
@@ -30,6 +30,42 @@
 #include <QCoreApplication>
 #include <roi_event.hpp>
 #include <QInputDialog>
+#include <QFileInfo>
+
+#define FACE_MODEL_PATH "./model/face_model.onnx"
+
+namespace
+{
+    // 校准页面上与形态键对应的控件：显示输出的进度条和调整增益的滑动条
+    struct BlendShapeBinding
+    {
+        BlendShape shape;
+        QProgressBar* Ui_PaperFaceTrackerMainWindow::* value;
+        QScrollBar* Ui_PaperFaceTrackerMainWindow::* amp;
+    };
+
+    constexpr BlendShapeBinding kBlendShapeBindings[] = {
+        {BlendShape::cheekPuffLeft, &Ui_PaperFaceTrackerMainWindow::CheekPullLeftValue, &Ui_PaperFaceTrackerMainWindow::CheekPuffLeftBar},
+        {BlendShape::cheekPuffRight, &Ui_PaperFaceTrackerMainWindow::CheekPullRightValue, &Ui_PaperFaceTrackerMainWindow::CheekPuffRightBar},
+        {BlendShape::jawOpen, &Ui_PaperFaceTrackerMainWindow::JawOpenValue, &Ui_PaperFaceTrackerMainWindow::JawOpenBar},
+        {BlendShape::jawLeft, &Ui_PaperFaceTrackerMainWindow::JawLeftValue, &Ui_PaperFaceTrackerMainWindow::JawLeftBar},
+        {BlendShape::jawRight, &Ui_PaperFaceTrackerMainWindow::JawRightValue, &Ui_PaperFaceTrackerMainWindow::JawRightBar},
+        {BlendShape::mouthLeft, &Ui_PaperFaceTrackerMainWindow::MouthLeftValue, &Ui_PaperFaceTrackerMainWindow::MouthLeftBar},
+        {BlendShape::mouthRight, &Ui_PaperFaceTrackerMainWindow::MouthRightValue, &Ui_PaperFaceTrackerMainWindow::MouthRightBar},
+        {BlendShape::tongueOut, &Ui_PaperFaceTrackerMainWindow::TongueOutValue, &Ui_PaperFaceTrackerMainWindow::TongueOutBar},
+        {BlendShape::tongueUp, &Ui_PaperFaceTrackerMainWindow::TongueUpValue, &Ui_PaperFaceTrackerMainWindow::TongueUpBar},
+        {BlendShape::tongueDown, &Ui_PaperFaceTrackerMainWindow::TongueDownValue, &Ui_PaperFaceTrackerMainWindow::TongueDownBar},
+        {BlendShape::tongueLeft, &Ui_PaperFaceTrackerMainWindow::TongueLeftValue, &Ui_PaperFaceTrackerMainWindow::TongueLeftBar},
+        {BlendShape::tongueRight, &Ui_PaperFaceTrackerMainWindow::TongueRightValue, &Ui_PaperFaceTrackerMainWindow::TongueRightBar},
+        {BlendShape::mouthClose, &Ui_PaperFaceTrackerMainWindow::MouthCloseValue, &Ui_PaperFaceTrackerMainWindow::MouthCloseBar},
+        {BlendShape::mouthFunnel, &Ui_PaperFaceTrackerMainWindow::MouthFunnelValue, &Ui_PaperFaceTrackerMainWindow::MouthFunnelBar},
+        {BlendShape::mouthPucker, &Ui_PaperFaceTrackerMainWindow::MouthPuckerValue, &Ui_PaperFaceTrackerMainWindow::MouthPuckerBar},
+        {BlendShape::mouthRollUpper, &Ui_PaperFaceTrackerMainWindow::MouthRollUpperValue, &Ui_PaperFaceTrackerMainWindow::MouthRollUpperBar},
+        {BlendShape::mouthRollLower, &Ui_PaperFaceTrackerMainWindow::MouthRollLowerValue, &Ui_PaperFaceTrackerMainWindow::MouthRollLowerBar},
+        {BlendShape::mouthShrugUpper, &Ui_PaperFaceTrackerMainWindow::MouthShrugUpperValue, &Ui_PaperFaceTrackerMainWindow::MouthShrugUpperBar},
+        {BlendShape::mouthShrugLower, &Ui_PaperFaceTrackerMainWindow::MouthShrugLowerValue, &Ui_PaperFaceTrackerMainWindow::MouthShrugLowerBar},
+    };
+}
 
 PaperFaceTrackerWindow::PaperFaceTrackerWindow(QWidget *parent)
     : QWidget(parent)
@@ -120,15 +156,6 @@ PaperFaceTrackerWindow::PaperFaceTrackerWindow(QWidget *parent)
     inference = std::make_shared<FaceInference>();
     osc_manager = std::make_shared<OscManager>();
     set_config();
-    // Load model
-    LOG_INFO("正在加载推理模型...");
-    try {
-        inference->load_model("");
-        LOG_INFO("模型加载完成");
-    } catch (const std::exception& e) {
-        // 使用Qt方式记录日志，而不是minilog
-        LOG_ERROR("错误: 模型加载异常: {}", e.what());
-    }
     // 初始化OSC管理器
     LOG_INFO("正在初始化OSC...");
     if (osc_manager->init("127.0.0.1", 8888)) {
@@ -140,6 +167,9 @@ PaperFaceTrackerWindow::PaperFaceTrackerWindow(QWidget *parent)
     // 初始化串口和wifi
     serial_port_manager = std::make_shared<SerialPortManager>();
     image_downloader = std::make_shared<ESP32VideoStream>();
+    // 推理只用灰度，预览和推理都会缩放到 280x280，解码时直接输出不小于该尺寸的灰度图
+    image_downloader->setDecodeOptions({true, cv::Size(280, 280)});
+    image_downloader->setFrameSignal(frame_signal);
     LOG_INFO("初始化有线模式");
     serial_port_manager->init();
     // init serial port manager
@@ -213,6 +243,7 @@ PaperFaceTrackerWindow::PaperFaceTrackerWindow(QWidget *parent)
     set_config();
     setupKalmanFilterControls();
     create_sub_threads();
+    setup_model_watcher();
     // 创建自动保存配置的定时器
     auto_save_timer = new QTimer(this);
     connect(auto_save_timer, &QTimer::timeout, this, [this]() {
@@ -281,6 +312,36 @@ void PaperFaceTrackerWindow::bound_pages() {
 }
 
 // 添加事件过滤器实现
+void PaperFaceTrackerWindow::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    updatePreviewVisibility();
+}
+
+void PaperFaceTrackerWindow::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    updatePreviewVisibility();
+}
+
+void PaperFaceTrackerWindow::changeEvent(QEvent *event)
+{
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange)
+    {
+        updatePreviewVisibility();
+    }
+}
+
+void PaperFaceTrackerWindow::updatePreviewVisibility()
+{
+    // 窗口隐藏或最小化时没有预览，解码只需覆盖 ROI
+    if (image_downloader)
+    {
+        image_downloader->setFullFrameRequired(isVisible() && !isMinimized());
+    }
+}
+
 bool PaperFaceTrackerWindow::eventFilter(QObject *obj, QEvent *event)
 {
     // 处理焦点获取事件
@@ -314,86 +375,19 @@ bool PaperFaceTrackerWindow::eventFilter(QObject *obj, QEvent *event)
 }
 
 // 根据模型输出更新校准页面的进度条
-void PaperFaceTrackerWindow::updateCalibrationProgressBars(
-    const std::vector<float>& output,
-    const std::unordered_map<std::string, size_t>& blendShapeIndexMap
-) {
+void PaperFaceTrackerWindow::updateCalibrationProgressBars(const std::vector<float>& output) {
     if (output.empty() || ui.stackedWidget->currentIndex() != 1) {
         // 如果输出为空或者当前不在校准页面，则不更新
         return;
     }
 
     // 使用Qt的线程安全方式更新UI
-    QMetaObject::invokeMethod(this, [this, output, &blendShapeIndexMap]() {
-        // 将值缩放到0-100范围内用于进度条显示
-        auto scaleValue = [](const float value) -> int {
-            // 将值限制在0-1.0范围内，然后映射到0-100
-            return static_cast<int>(value * 100);
-        };
-
-        // 更新各个进度条
-        // 注意：这里假设输出数组中的索引与ARKit模型输出的顺序一致
-
-        // 脸颊
-        if (blendShapeIndexMap.contains("cheekPuffLeft") && blendShapeIndexMap.at("cheekPuffLeft") < output.size()) {
-            ui.CheekPullLeftValue->setValue(scaleValue(output[blendShapeIndexMap.at("cheekPuffLeft")]));
-        }
-        if (blendShapeIndexMap.contains("cheekPuffRight") && blendShapeIndexMap.at("cheekPuffRight") < output.size()) {
-            ui.CheekPullRightValue->setValue(scaleValue(output[blendShapeIndexMap.at("cheekPuffRight")]));
-        }
-        // 下巴
-        if (blendShapeIndexMap.contains("jawOpen") && blendShapeIndexMap.at("jawOpen") < output.size()) {
-            ui.JawOpenValue->setValue(scaleValue(output[blendShapeIndexMap.at("jawOpen")]));
-        }
-        if (blendShapeIndexMap.contains("jawLeft") && blendShapeIndexMap.at("jawLeft") < output.size()) {
-            ui.JawLeftValue->setValue(scaleValue(output[blendShapeIndexMap.at("jawLeft")]));
-        }
-        if (blendShapeIndexMap.contains("jawRight") && blendShapeIndexMap.at("jawRight") < output.size()) {
-            ui.JawRightValue->setValue(scaleValue(output[blendShapeIndexMap.at("jawRight")]));
-        }
-        // 嘴巴
-        if (blendShapeIndexMap.contains("mouthLeft") && blendShapeIndexMap.at("mouthLeft") < output.size()) {
-            ui.MouthLeftValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthLeft")]));
-        }
-        if (blendShapeIndexMap.contains("mouthRight") && blendShapeIndexMap.at("mouthRight") < output.size()) {
-            ui.MouthRightValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthRight")]));
-        }
-        // 舌头
-        if (blendShapeIndexMap.contains("tongueOut") && blendShapeIndexMap.at("tongueOut") < output.size()) {
-            ui.TongueOutValue->setValue(scaleValue(output[blendShapeIndexMap.at("tongueOut")]));
-        }
-        if (blendShapeIndexMap.contains("tongueUp") && blendShapeIndexMap.at("tongueUp") < output.size()) {
-            ui.TongueUpValue->setValue(scaleValue(output[blendShapeIndexMap.at("tongueUp")]));
-        }
-        if (blendShapeIndexMap.contains("tongueDown") && blendShapeIndexMap.at("tongueDown") < output.size()) {
-            ui.TongueDownValue->setValue(scaleValue(output[blendShapeIndexMap.at("tongueDown")]));
-        }
-        if (blendShapeIndexMap.contains("tongueLeft") && blendShapeIndexMap.at("tongueLeft") < output.size()) {
-            ui.TongueLeftValue->setValue(scaleValue(output[blendShapeIndexMap.at("tongueLeft")]));
-        }
-        if (blendShapeIndexMap.contains("tongueRight") && blendShapeIndexMap.at("tongueRight") < output.size()) {
-            ui.TongueRightValue->setValue(scaleValue(output[blendShapeIndexMap.at("tongueRight")]));
-        }
-        if (blendShapeIndexMap.contains("mouthClose") && blendShapeIndexMap.at("mouthClose") < output.size()) {
-            ui.MouthCloseValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthClose")]));
-        }
-        if (blendShapeIndexMap.contains("mouthFunnel") && blendShapeIndexMap.at("mouthFunnel") < output.size()) {
-            ui.MouthFunnelValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthFunnel")]));
-        }
-        if (blendShapeIndexMap.contains("mouthPucker") && blendShapeIndexMap.at("mouthPucker") < output.size()) {
-            ui.MouthPuckerValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthPucker")]));
-        }
-        if (blendShapeIndexMap.contains("mouthRollUpper") && blendShapeIndexMap.at("mouthRollUpper") < output.size()) {
-            ui.MouthRollUpperValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthRollUpper")]));
-        }
-        if (blendShapeIndexMap.contains("mouthRollLower") && blendShapeIndexMap.at("mouthRollLower") < output.size()) {
-            ui.MouthRollLowerValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthRollLower")]));
-        }
-        if (blendShapeIndexMap.contains("mouthShrugUpper") && blendShapeIndexMap.at("mouthShrugUpper") < output.size()) {
-            ui.MouthShrugUpperValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthShrugUpper")]));
-        }
-        if (blendShapeIndexMap.contains("mouthShrugLower") && blendShapeIndexMap.at("mouthShrugLower") < output.size()) {
-            ui.MouthShrugLowerValue->setValue(scaleValue(output[blendShapeIndexMap.at("mouthShrugLower")]));
+    QMetaObject::invokeMethod(this, [this, output]() {
+        // 将0-1的输出映射到0-100用于进度条显示
+        for (const auto& binding : kBlendShapeBindings) {
+            if (index_of(binding.shape) < output.size()) {
+                (ui.*binding.value)->setValue(static_cast<int>(output[index_of(binding.shape)] * 100));
+            }
         }
     }, Qt::QueuedConnection);
 }
@@ -679,20 +673,7 @@ PaperFaceTrackerConfig PaperFaceTrackerWindow::generate_config() const
     res_config.energy_mode = ui.EnergyModeBox->currentIndex();
     res_config.use_filter = ui.UseFilterBox->isChecked();
     res_config.wifi_ip = ui.textEdit->toPlainText().toStdString();
-    res_config.amp_map = {
-        {"cheekPuffLeft", ui.CheekPuffLeftBar->value()},
-        {"cheekPuffRight", ui.CheekPuffRightBar->value()},
-        {"jawOpen", ui.JawOpenBar->value()},
-        {"jawLeft", ui.JawLeftBar->value()},
-        {"jawRight", ui.JawRightBar->value()},
-        {"mouthLeft", ui.MouthLeftBar->value()},
-        {"mouthRight", ui.MouthRightBar->value()},
-        {"tongueOut", ui.TongueOutBar->value()},
-        {"tongueUp", ui.TongueUpBar->value()},
-        {"tongueDown", ui.TongueDownBar->value()},
-        {"tongueLeft", ui.TongueLeftBar->value()},
-        {"tongueRight", ui.TongueRightBar->value()},
-    };
+    res_config.amp_map = getAmpMap();
     // 添加偏置值
     res_config.cheek_puff_left_offset = cheek_puff_left_offset;
     res_config.cheek_puff_right_offset = cheek_puff_right_offset;
@@ -704,6 +685,12 @@ PaperFaceTrackerConfig PaperFaceTrackerWindow::generate_config() const
     res_config.dt = current_dt;
     res_config.q_factor = current_q_factor;
     res_config.r_factor = current_r_factor;
+    res_config.output_filter = output_filter_settings;
+    // 帧差门控默认关闭，目前只能在配置文件中开启，原样保存
+    res_config.change_gate = config.change_gate;
+    res_config.cascade = config.cascade;
+    res_config.uint8_input = config.uint8_input;
+    res_config.execution_provider = config.execution_provider;
     res_config.mouth_close_offset = mouth_close_offset;
     res_config.mouth_funnel_offset = mouth_funnel_offset;
     res_config.mouth_pucker_offset = mouth_pucker_offset;
@@ -749,6 +736,17 @@ void PaperFaceTrackerWindow::set_config()
     if (qFactorLineEdit) qFactorLineEdit->setText(QString::number(current_q_factor, 'f', 2));
     if (rFactorLineEdit) rFactorLineEdit->setText(QString::number(current_r_factor, 'f', 6));
 
+    // 加载滤波算法
+    output_filter_settings = config.output_filter;
+    if (filterTypeBox) filterTypeBox->setCurrentIndex(filterTypeBox->findData(static_cast<int>(output_filter_settings.defaults.type)));
+    if (minCutoffLineEdit) minCutoffLineEdit->setText(QString::number(output_filter_settings.defaults.min_cutoff, 'f', 2));
+    if (betaLineEdit) betaLineEdit->setText(QString::number(output_filter_settings.defaults.beta, 'f', 2));
+    inference->set_output_filter(output_filter_settings);
+    inference->set_change_gate(config.change_gate);
+    inference->set_cascade(config.cascade);
+    inference->set_uint8_input(config.uint8_input);
+    inference->set_execution_provider(config.execution_provider);
+
     // 设置输入框的文本
     ui.CheekPuffLeftOffset->setText(QString::number(cheek_puff_left_offset));
     ui.CheekPuffRightOffset->setText(QString::number(cheek_puff_right_offset));
@@ -767,33 +765,10 @@ void PaperFaceTrackerWindow::set_config()
     // 更新偏置值到推理引擎
     updateOffsetsToInference();
 
-    try
-    {
-        ui.CheekPuffLeftBar->setValue(config.amp_map.at("cheekPuffLeft"));
-        ui.CheekPuffRightBar->setValue(config.amp_map.at("cheekPuffRight"));
-        ui.JawOpenBar->setValue(config.amp_map.at("jawOpen"));
-        ui.JawLeftBar->setValue(config.amp_map.at("jawLeft"));
-        ui.JawRightBar->setValue(config.amp_map.at("jawRight"));
-        ui.MouthLeftBar->setValue(config.amp_map.at("mouthLeft"));
-        ui.MouthRightBar->setValue(config.amp_map.at("mouthRight"));
-        ui.TongueOutBar->setValue(config.amp_map.at("tongueOut"));
-        ui.TongueUpBar->setValue(config.amp_map.at("tongueUp"));
-        ui.TongueDownBar->setValue(config.amp_map.at("tongueDown"));
-        ui.TongueLeftBar->setValue(config.amp_map.at("tongueLeft"));
-        ui.TongueRightBar->setValue(config.amp_map.at("tongueRight"));
-
-        // 新增的滑动条设置（先检查是否存在对应的键，不存在则使用默认值）
-        ui.MouthCloseBar->setValue(config.amp_map.count("mouthClose") > 0 ? config.amp_map.at("mouthClose") : 0);
-        ui.MouthFunnelBar->setValue(config.amp_map.count("mouthFunnel") > 0 ? config.amp_map.at("mouthFunnel") : 0);
-        ui.MouthPuckerBar->setValue(config.amp_map.count("mouthPucker") > 0 ? config.amp_map.at("mouthPucker") : 0);
-        ui.MouthRollUpperBar->setValue(config.amp_map.count("mouthRollUpper") > 0 ? config.amp_map.at("mouthRollUpper") : 0);
-        ui.MouthRollLowerBar->setValue(config.amp_map.count("mouthRollLower") > 0 ? config.amp_map.at("mouthRollLower") : 0);
-        ui.MouthShrugUpperBar->setValue(config.amp_map.count("mouthShrugUpper") > 0 ? config.amp_map.at("mouthShrugUpper") : 0);
-        ui.MouthShrugLowerBar->setValue(config.amp_map.count("mouthShrugLower") > 0 ? config.amp_map.at("mouthShrugLower") : 0);
-    }
-    catch (std::exception& e)
-    {
-        LOG_ERROR("配置文件中的振幅映射错误: {}", e.what());
+    // 配置文件中没有的形态键使用默认值 0
+    for (const auto& binding : kBlendShapeBindings) {
+        auto it = config.amp_map.find(std::string(blendshape_name(binding.shape)));
+        (ui.*binding.amp)->setValue(it != config.amp_map.end() ? it->second : 0);
     }
     roi_rect = config.rect;
 }
@@ -963,28 +938,11 @@ void PaperFaceTrackerWindow::onMouthShrugLowerOffsetChanged()
 }
 std::unordered_map<std::string, int> PaperFaceTrackerWindow::getAmpMap() const
 {
-    return {
-            {"cheekPuffLeft", ui.CheekPuffLeftBar->value()},
-            {"cheekPuffRight", ui.CheekPuffRightBar->value()},
-            {"jawOpen", ui.JawOpenBar->value()},
-            {"jawLeft", ui.JawLeftBar->value()},
-            {"jawRight", ui.JawRightBar->value()},
-            {"mouthLeft", ui.MouthLeftBar->value()},
-            {"mouthRight", ui.MouthRightBar->value()},
-            {"tongueOut", ui.TongueOutBar->value()},
-            {"tongueUp", ui.TongueUpBar->value()},
-            {"tongueDown", ui.TongueDownBar->value()},
-            {"tongueLeft", ui.TongueLeftBar->value()},
-            {"tongueRight", ui.TongueRightBar->value()},
-            // 添加新的形态键
-            {"mouthClose", ui.MouthCloseBar->value()},
-            {"mouthFunnel", ui.MouthFunnelBar->value()},
-            {"mouthPucker", ui.MouthPuckerBar->value()},
-            {"mouthRollUpper", ui.MouthRollUpperBar->value()},
-            {"mouthRollLower", ui.MouthRollLowerBar->value()},
-            {"mouthShrugUpper", ui.MouthShrugUpperBar->value()},
-            {"mouthShrugLower", ui.MouthShrugLowerBar->value()},
-        };
+    std::unordered_map<std::string, int> amp_map;
+    for (const auto& binding : kBlendShapeBindings) {
+        amp_map.emplace(blendshape_name(binding.shape), (ui.*binding.amp)->value());
+    }
+    return amp_map;
 }
 
 void PaperFaceTrackerWindow::start_image_download() const
@@ -1029,9 +987,9 @@ void PaperFaceTrackerWindow::updateSerialLabel() const
     }
 }
 
-cv::Mat PaperFaceTrackerWindow::getVideoImage() const
+FrameRef PaperFaceTrackerWindow::getVideoImage() const
 {
-    return std::move(image_downloader->getLatestFrame());
+    return image_downloader->getLatestFrame();
 }
 
 std::string PaperFaceTrackerWindow::getFirmwareVersion() const
@@ -1089,11 +1047,19 @@ void PaperFaceTrackerWindow::create_sub_threads()
                 fps_total += fps;
                 fps_count += 1;
                 fps = fps_total/fps_count;
-                cv::Mat frame = getVideoImage();
-                if (!frame.empty())
+                // 共享帧只读，缩放后写入自己的缓冲区再绘制
+                FrameRef video_frame = getVideoImage();
+                cv::Mat frame;
+                if (video_frame && !video_frame->image.empty())
                 {
                     auto rotate_angle = getRotateAngle();
-                    cv::resize(frame, frame, cv::Size(280, 280), cv::INTER_NEAREST);
+                    // 预览刚显示时的帧可能仍只解码了 ROI，区域外清零后再显示
+                    cv::resize(video_frame->valid_image(), frame, cv::Size(280, 280), cv::INTER_NEAREST);
+                    // 灰度帧缩放后再转为三通道，预览按 RGB888 显示且需要彩色标注
+                    if (frame.channels() == 1)
+                    {
+                        cv::cvtColor(frame, frame, cv::COLOR_GRAY2BGR);
+                    }
                     int y = frame.rows / 2;
                     int x = frame.cols / 2;
                     auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(x, y), rotate_angle, 1);
@@ -1127,12 +1093,55 @@ void PaperFaceTrackerWindow::create_sub_threads()
 
     inference_thread = std::thread([this] ()
     {
+        // 在推理线程中加载模型，避免打开窗口时界面卡顿
+        LOG_INFO("正在加载推理模型...");
+        try {
+            inference->load_model(FACE_MODEL_PATH);
+        } catch (const std::exception& e) {
+            LOG_ERROR("错误: 模型加载异常: {}", e.what());
+        }
         auto last_time = std::chrono::high_resolution_clock::now();
         double fps_total = 0;
         double fps_count = 0;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // 推理前的缩放、旋转写入该缓冲区，尺寸不变时每帧复用
+        cv::Mat frame_buffer;
+        uint64_t signal_seen = 0;
+        uint64_t last_seq = 0;
+        std::chrono::steady_clock::time_point last_infer_time;
         while (is_running())
         {
+            if (model_reload_requested.exchange(false))
+            {
+                inference->reload_model_async(FACE_MODEL_PATH);
+            }
+            // 模型未就绪时不进行推理
+            if (!inference->is_ready())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                last_time = std::chrono::high_resolution_clock::now();
+                continue;
+            }
+            // 等待新帧到达，每帧只推理一次；超时后回到循环开头检查退出和模型重载
+            signal_seen = frame_signal->wait_for(signal_seen, std::chrono::milliseconds(100));
+            FrameRef video_frame = getVideoImage();
+            if (!video_frame || video_frame->seq == last_seq)
+            {
+                continue;
+            }
+            // max_fps 只是上限：距上次推理不足最小间隔时等满间隔，再取期间到达的最新帧
+            const auto min_interval = std::chrono::microseconds(1000000 / max(1, get_max_fps()));
+            if (std::chrono::steady_clock::now() < last_infer_time + min_interval)
+            {
+                std::this_thread::sleep_until(last_infer_time + min_interval);
+                // 视频流在等待期间停止时仍用手上的帧
+                if (FrameRef newer = getVideoImage())
+                {
+                    video_frame = std::move(newer);
+                }
+            }
+            last_infer_time = std::chrono::steady_clock::now();
+            last_seq = video_frame->seq;
+
             if (fps_total > 1000)
             {
                 fps_count = 0;
@@ -1148,37 +1157,48 @@ void PaperFaceTrackerWindow::create_sub_threads()
             fps = fps_total/fps_count;
             // LOG_DEBUG("模型FPS： {}", fps);
 
-            auto start_time = std::chrono::high_resolution_clock::now();
             // 设置时间序列
             inference->set_dt(duration.count() / 1000.0);
 
-            auto frame = getVideoImage();
             // 推理处理
-            if (!frame.empty())
+            if (video_frame && !video_frame->image.empty())
             {
+                const auto frame_time = video_frame->received_at;
                 auto rotate_angle = getRotateAngle();
-                cv::resize(frame, frame, cv::Size(280, 280), cv::INTER_NEAREST);
+                auto roi_rect = getRoiRect();
+                const cv::Size frame_size(280, 280);
+                const cv::Rect2f source_region = roi_rect.is_roi_end
+                    ? roi_source_region(roi_rect.rect, frame_size, rotate_angle) : cv::Rect2f();
+                // 下一帧只解码 ROI 覆盖的源图区域，预览可见时仍解码整帧
+                image_downloader->setDecodeRegion(source_region);
+                // 按旧 ROI 只解码了部分区域的帧不一定覆盖当前 ROI，区域外是旧内容，跳过这一帧
+                if (!video_frame->covers(source_region))
+                {
+                    continue;
+                }
+                // 缩放结果写入推理线程自己的缓冲区，之后的旋转和裁剪不影响共享帧
+                cv::resize(video_frame->image, frame_buffer, frame_size, cv::INTER_NEAREST);
+                cv::Mat& frame = frame_buffer;
                 int y = frame.rows / 2;
                 int x = frame.cols / 2;
                 auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(x, y), rotate_angle, 1);
                 cv::warpAffine(frame, frame, rotate_matrix, frame.size(), cv::INTER_NEAREST);
-                cv::Mat infer_frame;
-                infer_frame = frame.clone();
-                auto roi_rect = getRoiRect();
+                cv::Mat infer_frame = frame;
                 if (!roi_rect.rect.empty() && roi_rect.is_roi_end)
                 {
                     infer_frame = infer_frame(roi_rect.rect);
                 }
                 inference->inference(infer_frame);
+                // 从收到图像到现在的耗时，供延迟补偿使用
+                inference->set_pipeline_latency(
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_time).count());
                 {
                     std::lock_guard<std::mutex> lock(outputs_mutex);
-                    outputs = inference->get_output();
+                    auto output = inference->get_output();
+                    // 复用 outputs 已有的容量，避免每帧分配
+                    outputs.assign(output.begin(), output.end());
                 }
             }
-            auto end_time = std::chrono::high_resolution_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            int delay_ms = max(0, static_cast<int>(1000.0 / get_max_fps() - elapsed));
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
         }
     });
 
@@ -1208,8 +1228,8 @@ void PaperFaceTrackerWindow::create_sub_threads()
          {
              std::lock_guard<std::mutex> lock(outputs_mutex);
              if (!outputs.empty()) {
-                updateCalibrationProgressBars(outputs, inference->getBlendShapeIndexMap());
-                osc_manager->sendModelOutput(outputs, blend_shapes);
+                updateCalibrationProgressBars(outputs);
+                osc_manager->sendModelOutput(std::span<const float>(outputs));
              }
          }
 
@@ -1343,6 +1363,35 @@ void PaperFaceTrackerWindow::setupKalmanFilterControls() {
     qFactorLabel->setStyleSheet(labelStyle);
     rFactorLabel->setStyleSheet(labelStyle);
     helpLabel->setStyleSheet(labelStyle);
+
+    // 滤波算法选择，分组单独设置只能在配置文件中修改
+    QLabel* filterTypeLabel = new QLabel("滤波算法:", ui.page_2);
+    filterTypeLabel->setGeometry(QRect(720, 10, 115, 20));
+    filterTypeBox = new QComboBox(ui.page_2);
+    filterTypeBox->setGeometry(QRect(720, 32, 110, 25));
+    filterTypeBox->addItem("卡尔曼", static_cast<int>(OutputFilterType::Kalman));
+    filterTypeBox->addItem("一欧元", static_cast<int>(OutputFilterType::OneEuro));
+    filterTypeBox->addItem("不滤波", static_cast<int>(OutputFilterType::None));
+    filterTypeBox->setCurrentIndex(filterTypeBox->findData(static_cast<int>(output_filter_settings.defaults.type)));
+
+    // 一欧元滤波参数：最小截止频率和速度系数
+    QLabel* oneEuroLabel = new QLabel("截止频率 / beta:", ui.page_2);
+    oneEuroLabel->setGeometry(QRect(720, 62, 115, 20));
+    minCutoffLineEdit = new QLineEdit(ui.page_2);
+    minCutoffLineEdit->setGeometry(QRect(720, 84, 52, 25));
+    minCutoffLineEdit->setText(QString::number(output_filter_settings.defaults.min_cutoff, 'f', 2));
+    minCutoffLineEdit->setToolTip("一欧元滤波静止时的截止频率(Hz)，越小越平滑");
+    betaLineEdit = new QLineEdit(ui.page_2);
+    betaLineEdit->setGeometry(QRect(778, 84, 52, 25));
+    betaLineEdit->setText(QString::number(output_filter_settings.defaults.beta, 'f', 2));
+    betaLineEdit->setToolTip("一欧元滤波速度系数，越大快速动作时延迟越小");
+
+    connect(filterTypeBox, &QComboBox::currentIndexChanged, this, &PaperFaceTrackerWindow::onFilterTypeChanged);
+    connect(minCutoffLineEdit, &QLineEdit::editingFinished, this, &PaperFaceTrackerWindow::onOneEuroEditingFinished);
+    connect(betaLineEdit, &QLineEdit::editingFinished, this, &PaperFaceTrackerWindow::onOneEuroEditingFinished);
+
+    filterTypeLabel->setStyleSheet(labelStyle);
+    oneEuroLabel->setStyleSheet(labelStyle);
 }
 void PaperFaceTrackerWindow::onDtEditingFinished() {
     bool ok;
@@ -1387,4 +1436,59 @@ void PaperFaceTrackerWindow::onRFactorEditingFinished() {
         // 输入无效，恢复原值
         rFactorLineEdit->setText(QString::number(current_r_factor, 'f', 6));
     }
-}
\ No newline at end of file
+}
+
+void PaperFaceTrackerWindow::onFilterTypeChanged(int index) {
+    output_filter_settings.defaults.type = static_cast<OutputFilterType>(filterTypeBox->itemData(index).toInt());
+    if (inference) {
+        inference->set_output_filter(output_filter_settings);
+        LOG_INFO("滤波算法已切换为: {}", filterTypeBox->itemText(index).toStdString());
+    }
+}
+
+void PaperFaceTrackerWindow::onOneEuroEditingFinished() {
+    bool cutoff_ok;
+    bool beta_ok;
+    float min_cutoff = minCutoffLineEdit->text().toFloat(&cutoff_ok);
+    float beta = betaLineEdit->text().toFloat(&beta_ok);
+    if (cutoff_ok && min_cutoff > 0 && beta_ok && beta >= 0) {
+        output_filter_settings.defaults.min_cutoff = min_cutoff;
+        output_filter_settings.defaults.beta = beta;
+        if (inference) {
+            inference->set_output_filter(output_filter_settings);
+            LOG_INFO("一欧元滤波参数已更新: min_cutoff = {}, beta = {}", min_cutoff, beta);
+        }
+    } else {
+        // 输入无效，恢复原值
+        minCutoffLineEdit->setText(QString::number(output_filter_settings.defaults.min_cutoff, 'f', 2));
+        betaLineEdit->setText(QString::number(output_filter_settings.defaults.beta, 'f', 2));
+    }
+}
+
+void PaperFaceTrackerWindow::reload_model()
+{
+    // 由推理线程发起后台加载，推理实例只在推理线程中访问
+    model_reload_requested = true;
+}
+
+void PaperFaceTrackerWindow::setup_model_watcher()
+{
+    model_watcher = new QFileSystemWatcher(this);
+    model_watcher->addPath(FACE_MODEL_PATH);
+    // 文件写入可能分多次完成，最后一次变化一秒后再加载
+    model_reload_timer = new QTimer(this);
+    model_reload_timer->setSingleShot(true);
+    connect(model_watcher, &QFileSystemWatcher::fileChanged, this, [this](const QString&) {
+        model_reload_timer->start(1000);
+    });
+    connect(model_reload_timer, &QTimer::timeout, this, [this]() {
+        // 替换文件后监视会失效，需要重新添加
+        if (!model_watcher->files().contains(FACE_MODEL_PATH)) {
+            model_watcher->addPath(FACE_MODEL_PATH);
+        }
+        if (QFileInfo::exists(FACE_MODEL_PATH)) {
+            LOG_INFO("检测到模型文件更新，正在重新加载");
+            reload_model();
+        }
+    });
+}
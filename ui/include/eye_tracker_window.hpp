@@ -14,6 +14,7 @@
 #include "osc.hpp"
 #include "logger.hpp"
 #include <QTimer>
+#include <QFileSystemWatcher>
 #include "config_writer.hpp"
 #include "osc.hpp"
 #include "face_inference.hpp"
@@ -79,7 +80,18 @@ struct PaperEyeTrackerConfig
     double right_eye_fully_open = 30;
     double right_eye_fully_closed = 10.0;
     int eye_sync_mode = 0; // 默认为双眼独立控制
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(PaperEyeTrackerConfig, left_ip, right_ip, left_brightness,
+    // 滤波算法，可按分组（eyelid、pupil）单独指定
+    OutputFilterSettings output_filter;
+    // 画面未变化时跳过推理
+    ChangeGateConfig change_gate;
+    // 级联推理，小模型路径见 fast_model
+    CascadeConfig cascade;
+    // 模型直接接收 uint8 输入，归一化在模型内完成
+    bool uint8_input = false;
+    // 执行提供者，可选 auto、cpu、xnnpack、dnnl、openvino
+    ExecutionProviderConfig execution_provider;
+    // 缺少的字段使用默认值，旧版本的配置文件可以继续读取
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(PaperEyeTrackerConfig, left_ip, right_ip, left_brightness,
     right_brightness, energy_mode, left_roi, right_roi,
     left_calib_XMIN, left_calib_XMAX, left_calib_YMIN, left_calib_YMAX,
     left_calib_XOFF, left_calib_YOFF, left_has_calibration,
@@ -87,7 +99,7 @@ struct PaperEyeTrackerConfig
     right_calib_XOFF, right_calib_YOFF, right_has_calibration,
     left_flip_x, right_flip_x, flip_y, left_rotate_angle, right_rotate_angle,
     left_eye_fully_open, left_eye_fully_closed, right_eye_fully_open, right_eye_fully_closed,
-    eye_sync_mode);
+    eye_sync_mode, output_filter, change_gate, cascade, uint8_input, execution_provider);
 };
 
 class PaperEyeTrackerWindow : public QWidget {
@@ -110,7 +122,8 @@ public:
     void setVideoImage(int version, const cv::Mat& image);
     void updateWifiLabel(int version) const;
     void updateSerialLabel(int version) const;
-    cv::Mat getVideoImage(int version) const;
+    // 最新帧与其它读者共享，只读
+    FrameRef getVideoImage(int version) const;
 
     Rect getRoiRect(int version);
     float getRotateAngle(int version) const;
@@ -119,6 +132,13 @@ public:
     PaperEyeTrackerConfig generate_config() const;
     void enableTestMode(bool enable) { test_mode_enabled = enable; }
     bool isTestModeEnabled() const { return test_mode_enabled; }
+
+    // 在后台重新加载模型文件，加载完成后推理线程在下一帧切换，推理不中断
+    void reload_model();
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+    void changeEvent(QEvent* event) override;
 private slots:
     void onSendButtonClicked();
     void onRestartButtonClicked();
@@ -137,6 +157,8 @@ private slots:
     void onRightEyeValueIncrease();
     void onRightEyeValueDecrease();
 private:
+    // 预览是否可见决定解码整帧还是只解码 ROI
+    void updatePreviewVisibility();
     double compensated_eye_openness[EYE_NUM] = {0.0, 0.0};
     std::mutex compensated_data_mutex[EYE_NUM];
     bool test_mode_enabled = false;
@@ -145,6 +167,22 @@ private:
     double eye_fully_open[EYE_NUM] = {30.0, 30.0};    // 默认值
     double eye_fully_closed[EYE_NUM] = {10.0, 10.0};  // 默认值
     void create_sub_thread();
+    // 加载眼睛模型，模型不支持批量推理时退回单眼实例
+    void load_eye_models();
+    // 批量推理循环，左右眼一次 Run
+    void batch_inference_loop();
+    // 单眼推理循环，左右眼依次推理
+    void single_inference_loop();
+    // 等到任一只眼有新帧，并保证两次推理的间隔不小于 1/max_fps；没有新帧时返回 false
+    // gather_all 为 true 时再多等至多半个间隔，让两只眼的新帧尽量在同一次推理中处理
+    bool wait_for_frames(uint64_t& signal_seen, const uint64_t (&last_seq)[EYE_NUM],
+                         std::chrono::steady_clock::time_point& last_infer_time, bool gather_all);
+    // 取最新帧并完成缩放、旋转、ROI裁剪，roi 返回本帧使用的ROI；序号与 last_seq 相同时返回空，否则更新 last_seq；
+    // 帧的有效区域不覆盖当前 ROI（只解码了旧 ROI）时也返回空
+    cv::Mat prepare_inference_frame(int version, uint64_t& last_seq, cv::Rect& roi,
+                                    std::chrono::steady_clock::time_point& received_at);
+    // 将模型输出映射回图像坐标并更新开合度、瞳孔和校准数据
+    void process_eye_output(int version, std::vector<float>& temp, const cv::Rect& roi);
     void launchETVR();
     enum EyeSyncMode {
         NO_SYNC = 0,       // 双眼独立控制
@@ -165,9 +203,13 @@ private:
     Ui::PaperEyeTrackerWindow ui{};
 
     std::shared_ptr<ESP32VideoStream> image_stream[EYE_NUM];
+    // 左右眼视频流共用，任一路发布新帧都会唤醒推理线程
+    std::shared_ptr<FrameSignal> frame_signal = std::make_shared<FrameSignal>();
     std::shared_ptr<SerialPortManager> serial_port_;
     std::shared_ptr<OscManager> osc_manager;
     std::shared_ptr<EyeInference> inference_[EYE_NUM];
+    // 批量推理实例，模型不支持批量推理时在加载后置空
+    std::shared_ptr<EyeInference> batch_inference_;
 
     // 2 is left, 3 is right
     int current_esp32_version = 0;
@@ -246,6 +288,11 @@ private:
     // QSoundEffect* startSound;
     // QSoundEffect* endSound;
     QTimer* auto_save_timer= nullptr;
+    // 模型文件被替换后自动重新加载
+    void setup_model_watcher();
+    QFileSystemWatcher* model_watcher = nullptr;
+    QTimer* model_reload_timer = nullptr;
+    std::atomic<bool> model_reload_requested{false};
     // 用于绘制眼睛位置的自定义小部件
     class EyePositionWidget : public QWidget {
     public:
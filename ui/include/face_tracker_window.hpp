@@ -14,6 +14,7 @@
 #include <image_downloader.hpp>
 #include <osc.hpp>
 #include <QTimer>
+#include <QFileSystemWatcher>
 #include <QLineEdit>  // 确保包含该头文件
 #include "ui_face_tracker_window.h"
 #include "face_inference.hpp"
@@ -76,11 +77,22 @@ struct PaperFaceTrackerConfig {
     float r_factor = 0.0003f;
     std::unordered_map<std::string, int> amp_map;
     Rect rect;
-
-
-NLOHMANN_DEFINE_TYPE_INTRUSIVE(PaperFaceTrackerConfig, brightness, rotate_angle, energy_mode, wifi_ip, use_filter, amp_map, rect, cheek_puff_left_offset, cheek_puff_right_offset,
+    // 滤波算法，可按分组（cheek、jaw、mouth、nose、tongue）单独指定
+    OutputFilterSettings output_filter;
+    // 画面未变化时跳过推理
+    ChangeGateConfig change_gate;
+    // 级联推理，小模型路径见 fast_model
+    CascadeConfig cascade;
+    // 模型直接接收 uint8 输入，归一化在模型内完成
+    bool uint8_input = false;
+    // 执行提供者，可选 auto、cpu、xnnpack、dnnl、openvino
+    ExecutionProviderConfig execution_provider;
+
+// 缺少的字段使用默认值，旧版本的配置文件可以继续读取
+NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(PaperFaceTrackerConfig, brightness, rotate_angle, energy_mode, wifi_ip, use_filter, amp_map, rect, cheek_puff_left_offset, cheek_puff_right_offset,
     jaw_open_offset, tongue_out_offset, mouth_close_offset, mouth_funnel_offset, mouth_pucker_offset,
-    mouth_roll_upper_offset, mouth_roll_lower_offset, mouth_shrug_upper_offset, mouth_shrug_lower_offset, dt, q_factor, r_factor);};
+    mouth_roll_upper_offset, mouth_roll_lower_offset, mouth_shrug_upper_offset, mouth_shrug_lower_offset, dt, q_factor, r_factor,
+    output_filter, change_gate, cascade, uint8_input, execution_provider);};
 
 class PaperFaceTrackerWindow final : public QWidget {
 private:
@@ -102,10 +114,7 @@ public:
 
     void setVideoImage(const cv::Mat& image);
     // 根据模型输出更新校准页面的进度条
-    void updateCalibrationProgressBars(
-        const std::vector<float>& output,
-        const std::unordered_map<std::string, size_t>& blendShapeIndexMap
-    );
+    void updateCalibrationProgressBars(const std::vector<float>& output);
 
     using FuncWithoutArgs = std::function<void()>;
     using FuncWithVal = std::function<void(int)>;
@@ -128,10 +137,14 @@ public:
     void updateBatteryStatus() const;
     void updateSerialLabel() const;
 
-    cv::Mat getVideoImage() const;
+    // 最新帧与其它读者共享，只读
+    FrameRef getVideoImage() const;
     std::string getFirmwareVersion() const;
     SerialStatus getSerialStatus() const;
 
+    // 在后台重新加载模型文件，加载完成后推理线程在下一帧切换，推理不中断
+    void reload_model();
+
 private slots:
     void onCheekPuffLeftOffsetChanged();
     void onCheekPuffRightOffsetChanged();
@@ -178,6 +191,9 @@ private slots:
     void onDtEditingFinished();
     void onQFactorEditingFinished();
     void onRFactorEditingFinished();
+    // 滤波算法及一欧元滤波参数调整函数
+    void onFilterTypeChanged(int index);
+    void onOneEuroEditingFinished();
 
     // 设置卡尔曼滤波参数控制UI
     void setupKalmanFilterControls();
@@ -202,32 +218,6 @@ private:
 
     void create_sub_threads();
 
-    // 定义所有ARKit模型输出名称
-    const std::vector<std::string> blend_shapes =  {
-        "/cheekPuffLeft", "/cheekPuffRight",
-        "/cheekSuckLeft", "/cheekSuckRight",
-        "/jawOpen", "/jawForward", "/jawLeft", "/jawRight",
-        "/noseSneerLeft", "/noseSneerRight",
-        "/mouthFunnel", "/mouthPucker",
-        "/mouthLeft", "/mouthRight",
-        "/mouthRollUpper", "/mouthRollLower",
-        "/mouthShrugUpper", "/mouthShrugLower",
-        "/mouthClose",
-        "/mouthSmileLeft", "/mouthSmileRight",
-        "/mouthFrownLeft", "/mouthFrownRight",
-        "/mouthDimpleLeft", "/mouthDimpleRight",
-        "/mouthUpperUpLeft", "/mouthUpperUpRight",
-        "/mouthLowerDownLeft", "/mouthLowerDownRight",
-        "/mouthPressLeft", "/mouthPressRight",
-        "/mouthStretchLeft", "/mouthStretchRight",
-        "/tongueOut", "/tongueUp", "/tongueDown",
-        "/tongueLeft", "/tongueRight",
-        "/tongueRoll", "/tongueBendDown",
-        "/tongueCurlUp", "/tongueSquish",
-        "/tongueFlat", "/tongueTwistLeft",
-        "/tongueTwistRight"
-    };
-
     Rect roi_rect;
     void updateOffsetsToInference();
     std::thread update_thread;
@@ -238,6 +228,8 @@ private:
 
     std::shared_ptr<SerialPortManager> serial_port_manager;
     std::shared_ptr<ESP32VideoStream> image_downloader;
+    // 视频流每发布一帧通知一次，推理线程等待它而不是按 max_fps 轮询
+    std::shared_ptr<FrameSignal> frame_signal = std::make_shared<FrameSignal>();
     std::shared_ptr<FaceInference> inference;
     std::shared_ptr<OscManager> osc_manager;
     std::shared_ptr<ConfigWriter> config_writer;
@@ -258,6 +250,12 @@ private:
 
     QLabel* rFactorLabel = nullptr;
     QLineEdit* rFactorLineEdit = nullptr;
+
+    // 滤波算法选择
+    QComboBox* filterTypeBox = nullptr;
+    QLineEdit* minCutoffLineEdit = nullptr;
+    QLineEdit* betaLineEdit = nullptr;
+    OutputFilterSettings output_filter_settings;
     // 在private:部分的其他偏置值变量声明后添加
     float mouth_close_offset = 0.0f;
     float mouth_funnel_offset = 0.0f;
@@ -272,9 +270,20 @@ private:
     std::vector<float> outputs;
     std::mutex outputs_mutex;
     QTimer* auto_save_timer;
+    // 模型文件被替换后自动重新加载
+    void setup_model_watcher();
+    QFileSystemWatcher* model_watcher = nullptr;
+    QTimer* model_reload_timer = nullptr;
+    std::atomic<bool> model_reload_requested{false};
     inline static PaperFaceTrackerWindow* instance = nullptr;
 protected:
     bool eventFilter(QObject *obj, QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void changeEvent(QEvent *event) override;
+private:
+    // 预览是否可见决定解码整帧还是只解码 ROI
+    void updatePreviewVisibility();
 };
 
 #endif //PAPER_FACE_TRACKER_WINDOW_HPP
@@ -7,6 +7,7 @@
 
 #include <QObject>
 #include <QPainter>
+#include <opencv2/core.hpp>
 
 
 class ROIEventFilter final : public QObject {
@@ -23,5 +24,8 @@ private:
     std::function<void(QRect rect, bool is_end, int tag)> func;
 };
 
+// 把旋转后图像上的 ROI 映射回源图，返回归一化到 [0, 1] 的外接区域，用于只解码 ROI 覆盖的部分
+// frame_size 为缩放后、旋转前的图像尺寸；margin 为四周额外保留的像素，抵消最近邻采样的取整
+cv::Rect2f roi_source_region(const cv::Rect& roi, const cv::Size& frame_size, float rotate_angle, int margin = 4);
 
 #endif //ROI_EVENT_HPP
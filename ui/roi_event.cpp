@@ -23,6 +23,7 @@
 #include <QMouseEvent>
 #include <utility>
 #include <QRect>
+#include <opencv2/imgproc.hpp>
 
 ROIEventFilter::ROIEventFilter(std::function<void(QRect rect, bool is_end, int tag)> func, QObject *parent, int tag)
     : QObject(parent), selecting(false), tag_(tag)
@@ -71,3 +72,33 @@ bool ROIEventFilter::eventFilter(QObject *obj, QEvent *event) {
     }
     return QObject::eventFilter(obj, event);
 }
+
+cv::Rect2f roi_source_region(const cv::Rect& roi, const cv::Size& frame_size, float rotate_angle, int margin)
+{
+    if (roi.empty() || frame_size.empty()) {
+        return {};
+    }
+    // 旋转后的像素取自逆变换后的位置，ROI 四个角做逆变换后取外接矩形
+    const cv::Point2f center(frame_size.width / 2, frame_size.height / 2);
+    cv::Mat inverse;
+    cv::invertAffineTransform(cv::getRotationMatrix2D(center, rotate_angle, 1), inverse);
+    std::vector<cv::Point2f> corners = {
+        {static_cast<float>(roi.x), static_cast<float>(roi.y)},
+        {static_cast<float>(roi.x + roi.width), static_cast<float>(roi.y)},
+        {static_cast<float>(roi.x), static_cast<float>(roi.y + roi.height)},
+        {static_cast<float>(roi.x + roi.width), static_cast<float>(roi.y + roi.height)},
+    };
+    cv::transform(corners, corners, inverse);
+    cv::Rect2f bounds = cv::boundingRect(corners);
+    bounds.x -= static_cast<float>(margin);
+    bounds.y -= static_cast<float>(margin);
+    bounds.width += static_cast<float>(2 * margin);
+    bounds.height += static_cast<float>(2 * margin);
+    bounds &= cv::Rect2f(0, 0, static_cast<float>(frame_size.width), static_cast<float>(frame_size.height));
+    if (bounds.empty()) {
+        return {};
+    }
+    // 缩放前后各边按比例对应，归一化后与源图分辨率无关
+    return {bounds.x / frame_size.width, bounds.y / frame_size.height,
+            bounds.width / frame_size.width, bounds.height / frame_size.height};
+}
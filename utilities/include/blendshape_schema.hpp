@@ -0,0 +1,128 @@
+//
+// Created by JellyfishKnight on 25-7-10.
+//
+
+#ifndef BLENDSHAPE_SCHEMA_HPP
+#define BLENDSHAPE_SCHEMA_HPP
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// 面捕模型输出的 ARKit 形态键，顺序与模型输出一致，新增形态键只需在此追加一行
+#define PAPER_BLENDSHAPES(X) \
+    X(cheekPuffLeft)         \
+    X(cheekPuffRight)        \
+    X(cheekSuckLeft)         \
+    X(cheekSuckRight)        \
+    X(jawOpen)               \
+    X(jawForward)            \
+    X(jawLeft)               \
+    X(jawRight)              \
+    X(noseSneerLeft)         \
+    X(noseSneerRight)        \
+    X(mouthFunnel)           \
+    X(mouthPucker)           \
+    X(mouthLeft)             \
+    X(mouthRight)            \
+    X(mouthRollUpper)        \
+    X(mouthRollLower)        \
+    X(mouthShrugUpper)       \
+    X(mouthShrugLower)       \
+    X(mouthClose)            \
+    X(mouthSmileLeft)        \
+    X(mouthSmileRight)       \
+    X(mouthFrownLeft)        \
+    X(mouthFrownRight)       \
+    X(mouthDimpleLeft)       \
+    X(mouthDimpleRight)      \
+    X(mouthUpperUpLeft)      \
+    X(mouthUpperUpRight)     \
+    X(mouthLowerDownLeft)    \
+    X(mouthLowerDownRight)   \
+    X(mouthPressLeft)        \
+    X(mouthPressRight)       \
+    X(mouthStretchLeft)      \
+    X(mouthStretchRight)     \
+    X(tongueOut)             \
+    X(tongueUp)              \
+    X(tongueDown)            \
+    X(tongueLeft)            \
+    X(tongueRight)           \
+    X(tongueRoll)            \
+    X(tongueBendDown)        \
+    X(tongueCurlUp)          \
+    X(tongueSquish)          \
+    X(tongueFlat)            \
+    X(tongueTwistLeft)       \
+    X(tongueTwistRight)
+
+enum class BlendShape : size_t
+{
+#define PAPER_BLENDSHAPE_ENUM(name) name,
+    PAPER_BLENDSHAPES(PAPER_BLENDSHAPE_ENUM)
+#undef PAPER_BLENDSHAPE_ENUM
+    Count
+};
+
+inline constexpr size_t kBlendShapeCount = static_cast<size_t>(BlendShape::Count);
+
+constexpr size_t index_of(BlendShape shape)
+{
+    return static_cast<size_t>(shape);
+}
+
+// OSC 地址按协议要求以 '\0' 结尾并补齐到 4 字节的整数倍，可直接拷贝进数据包
+struct OscAddress
+{
+    static constexpr size_t kCapacity = 32;
+    std::array<char, kCapacity> data{};
+    size_t size = 0; // 补齐后的字节数
+
+    constexpr std::string_view padded() const { return {data.data(), size}; }
+};
+
+consteval OscAddress make_osc_address(std::string_view name)
+{
+    OscAddress address;
+    size_t length = 0;
+    address.data[length++] = '/';
+    for (char c : name) {
+        address.data[length++] = c;
+    }
+    // 至少一个 '\0'，再补齐到 4 的倍数
+    address.size = (length / 4 + 1) * 4;
+    if (address.size > OscAddress::kCapacity) {
+        throw "blendshape name too long for OscAddress";
+    }
+    return address;
+}
+
+struct BlendShapeInfo
+{
+    BlendShape shape;
+    std::string_view name;
+    OscAddress osc_address;
+};
+
+inline constexpr std::array<BlendShapeInfo, kBlendShapeCount> kBlendShapeSchema = {{
+#define PAPER_BLENDSHAPE_INFO(name) {BlendShape::name, #name, make_osc_address(#name)},
+    PAPER_BLENDSHAPES(PAPER_BLENDSHAPE_INFO)
+#undef PAPER_BLENDSHAPE_INFO
+}};
+
+constexpr const BlendShapeInfo& blendshape_info(BlendShape shape)
+{
+    return kBlendShapeSchema[index_of(shape)];
+}
+
+constexpr std::string_view blendshape_name(BlendShape shape)
+{
+    return blendshape_info(shape).name;
+}
+
+static_assert(blendshape_name(BlendShape::jawOpen) == "jawOpen");
+static_assert(blendshape_info(BlendShape::tongueTwistRight).osc_address.padded()
+              == std::string_view("/tongueTwistRight\0\0", 20));
+
+#endif //BLENDSHAPE_SCHEMA_HPP
@@ -0,0 +1,43 @@
+//
+// Created by JellyfishKnight on 25-7-4.
+//
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// 只读内存映射文件，映射期间文件内容由系统按需换入，不额外占用一份堆内存
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // path 为 UTF-8 编码的文件路径，失败时返回 false
+    bool open(const std::string& path);
+
+    void close();
+
+    bool is_open() const { return data_ != nullptr; }
+
+    const void* data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+private:
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif //MAPPED_FILE_HPP
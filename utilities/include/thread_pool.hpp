@@ -5,6 +5,7 @@
 #ifndef THREAD_POOL_HPP
 #define THREAD_POOL_HPP
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
@@ -98,6 +99,7 @@ public:
         for (auto& worker: m_workers) {
             worker.join();
         }
+        drop_pending_tasks();
     }
 
     void stop_now() {
@@ -107,6 +109,7 @@ public:
         for (auto& worker: m_workers) {
             worker.join();
         }
+        drop_pending_tasks();
     }
 
     // it won't take effect immediately because this will wait for enough workers to finish their current task
@@ -156,7 +159,7 @@ public:
     }
 
     [[nodiscard]] bool is_running() const {
-        return !m_stop;
+        return !m_stop.load();
     }
 
     ~ThreadPool() {
@@ -182,13 +185,23 @@ public:
 private:
     using Task = std::function<void(void)>;
 
+    // workers exit without running the queued tasks; destroy them now (outside the lock) instead of
+    // at destruction, so anything they capture is released and owners waiting on them can continue
+    void drop_pending_tasks() {
+        std::deque<Task> dropped;
+        {
+            std::lock_guard<std::mutex> lock(m_queue_mutex);
+            dropped.swap(m_tasks);
+        }
+    }
+
     std::vector<Worker> m_workers;
     std::deque<Task> m_tasks;
 
     std::mutex m_queue_mutex;
     std::condition_variable m_condition;
 
-    bool m_stop = false;
+    std::atomic<bool> m_stop{false};
 };
 
 } // namespace utils
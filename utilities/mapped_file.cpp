@@ -0,0 +1,123 @@
+//
+// Created by JellyfishKnight on 25-7-4.
+//
+#include "mapped_file.hpp"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+#ifdef _WIN32
+        file_handle_ = std::exchange(other.file_handle_, nullptr);
+        mapping_handle_ = std::exchange(other.mapping_handle_, nullptr);
+#endif
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+#ifdef _WIN32
+    int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (length <= 0) {
+        return false;
+    }
+    std::wstring wpath(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wpath.data(), length);
+
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_handle_ = file;
+    mapping_handle_ = mapping;
+    data_ = view;
+    size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // 映射建立后即可关闭文件描述符
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    data_ = view;
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle_ != nullptr) {
+        CloseHandle(mapping_handle_);
+    }
+    if (file_handle_ != nullptr) {
+        CloseHandle(file_handle_);
+    }
+    file_handle_ = nullptr;
+    mapping_handle_ = nullptr;
+#else
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}